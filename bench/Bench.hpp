@@ -0,0 +1,104 @@
+#ifndef BENCH_HPP
+#define BENCH_HPP
+
+#include <SDL3/SDL.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Minimal benchmark harness for the bench target (no external dependency).
+//
+// Each benchmark is a body that performs `iterations` operations. The runner
+// grows the iteration count until one sample takes at least minSampleMs,
+// then takes `samples` samples and reports the median time per operation.
+// An optional setup runs before every sample and is not timed.
+class BenchRunner {
+public:
+    struct Result {
+        std::string name;
+        std::string param;           // e.g. document size
+        uint64_t iterations = 0;     // Operations per sample
+        double nsPerOp = 0.0;        // Median
+        double minNsPerOp = 0.0;
+        double maxNsPerOp = 0.0;
+    };
+
+    using Body = std::function<void(uint64_t iterations)>;
+
+    std::string filter;              // Substring of "name/param"; empty runs all
+    double minSampleMs = 20.0;
+    int samples = 7;
+
+    void run(const std::string& name, const std::string& param, const Body& body) {
+        run(name, param, nullptr, body);
+    }
+
+    void run(const std::string& name, const std::string& param, const Body& setup, const Body& body) {
+        if (!selected(name, param)) return;
+
+        // Calibrate
+        uint64_t iterations = 1;
+        for (;;) {
+            if (setup) setup(iterations);
+            double ns = timeNs(body, iterations);
+            if (ns >= minSampleMs * 1e6 || iterations >= (uint64_t(1) << 30)) break;
+            // Aim a little past the target to converge in a few rounds
+            double scale = ns > 0.0 ? (minSampleMs * 1e6 * 1.2) / ns : 10.0;
+            iterations = std::max<uint64_t>(iterations + 1,
+                                            static_cast<uint64_t>(iterations * std::min(scale, 10.0)));
+        }
+
+        std::vector<double> perOp;
+        for (int i = 0; i < samples; i++) {
+            if (setup) setup(iterations);
+            perOp.push_back(timeNs(body, iterations) / static_cast<double>(iterations));
+        }
+        std::sort(perOp.begin(), perOp.end());
+
+        Result result;
+        result.name = name;
+        result.param = param;
+        result.iterations = iterations;
+        result.nsPerOp = perOp[perOp.size() / 2];
+        result.minNsPerOp = perOp.front();
+        result.maxNsPerOp = perOp.back();
+        results.push_back(result);
+
+        std::printf("%-34s %-12s %12.1f %14.0f %12.1f %12.1f\n", name.c_str(), param.c_str(),
+                    result.nsPerOp, 1e9 / result.nsPerOp, result.minNsPerOp, result.maxNsPerOp);
+        std::fflush(stdout);
+    }
+
+    void printHeader() const {
+        std::printf("%-34s %-12s %12s %14s %12s %12s\n", "benchmark", "param", "ns/op", "ops/s", "min", "max");
+        std::printf("%s\n", std::string(34 + 12 + 12 + 14 + 12 + 12 + 5, '-').c_str());
+    }
+
+    const std::vector<Result>& getResults() const { return results; }
+
+    // Keep a computed value alive so the optimiser cannot drop the work
+    template <typename T>
+    static void keep(const T& value) {
+        static volatile int64_t sink = 0;
+        sink = sink + static_cast<int64_t>(value);
+    }
+
+private:
+    std::vector<Result> results;
+
+    bool selected(const std::string& name, const std::string& param) const {
+        return filter.empty() || (name + "/" + param).find(filter) != std::string::npos;
+    }
+
+    static double timeNs(const Body& body, uint64_t iterations) {
+        Uint64 start = SDL_GetTicksNS();
+        body(iterations);
+        return static_cast<double>(SDL_GetTicksNS() - start);
+    }
+};
+
+#endif // BENCH_HPP
@@ -0,0 +1,357 @@
+// Micro-benchmarks for the hot paths: text editing, font lookups, Lua
+// binding overhead and software-renderer throughput.
+//
+// Usage: bench [--filter <substring>] [--json <file>] [--quick] [--font <file>]
+
+#include <SDL3/SDL.h>
+#include <SDL3_ttf/SDL_ttf.h>
+#include <sol/sol.hpp>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Bench.hpp"
+#include "../src/graphics/Compositor.hpp"
+#include "../src/graphics/FontManager.hpp"
+#include "../src/lua/LuaAllocator.hpp"
+#include "../src/lua/LuaBindings.hpp"
+#include "../src/widgets/TextWidget.hpp"
+
+#ifndef BENCH_ASSET_DIR
+#define BENCH_ASSET_DIR "assets"
+#endif
+
+#ifndef APP_VERSION
+#define APP_VERSION "unknown"
+#endif
+
+// Access to TextWidget's private editing helpers (declared friend there)
+class TextWidgetBench {
+public:
+    static size_t lineCount(TextWidget& w) { return w.getLines().size(); }
+    static int offsetFromX(TextWidget& w, const std::string& str, float x) { return w.getOffsetFromX(str, x); }
+    static void setCursor(TextWidget& w, int pos) { w.cursorPos = pos; }
+    static void clearHistory(TextWidget& w) {
+        w.undoStack.clear();
+        w.redoStack.clear();
+    }
+};
+
+// FFI target for the binding overhead comparison
+APP_FFI_EXPORT int bench_add(int a, int b) {
+    return a + b;
+}
+
+namespace {
+
+int rawAdd(lua_State* L) {
+    lua_Integer a = lua_tointeger(L, 1);
+    lua_Integer b = lua_tointeger(L, 2);
+    lua_pushinteger(L, a + b);
+    return 1;
+}
+
+// Lines of ~60 characters until the document reaches `bytes`
+std::string makeDocument(size_t bytes) {
+    static const char* words[] = {"lorem", "ipsum", "dolor", "sit", "amet", "consectetur",
+                                  "adipiscing", "elit", "sed", "do", "eiusmod", "tempor"};
+    std::string doc;
+    doc.reserve(bytes + 64);
+    size_t lineLength = 0;
+    for (size_t i = 0; doc.size() < bytes; i++) {
+        const char* word = words[i % 12];
+        doc += word;
+        lineLength += std::char_traits<char>::length(word);
+        if (lineLength >= 60) {
+            doc += '\n';
+            lineLength = 0;
+        } else {
+            doc += ' ';
+            lineLength++;
+        }
+    }
+    doc.resize(bytes);
+    return doc;
+}
+
+std::string sizeLabel(size_t bytes) {
+    return std::to_string(bytes / 1024) + " KB";
+}
+
+struct Context {
+    SDL_Surface* surface = nullptr;
+    SDL_Renderer* renderer = nullptr;
+    TTF_TextEngine* textEngine = nullptr;
+    FontManager fonts;
+    int fontId = -1;
+    TTF_Font* font = nullptr;
+};
+
+void benchTextWidget(BenchRunner& runner, Context& ctx) {
+    const size_t sizes[] = {1024, 16 * 1024, 256 * 1024};
+
+    for (size_t size : sizes) {
+        const std::string doc = makeDocument(size);
+        const std::string param = sizeLabel(size);
+
+        TextWidget widget;
+        widget.init(ctx.renderer, ctx.textEngine, ctx.font, nullptr);
+        widget.setMultiline(true);
+        widget.setSize(800, 600);
+        widget.setFocus(true);
+
+        auto reset = [&](int cursor) {
+            widget.setText(doc);
+            TextWidgetBench::clearHistory(widget);
+            TextWidgetBench::setCursor(widget, cursor);
+        };
+        const int middle = static_cast<int>(doc.size() / 2);
+
+        // Each insert/erase also snapshots the document for undo
+        runner.run("TextWidget insert (middle)", param,
+            [&](uint64_t) { reset(middle); },
+            [&](uint64_t n) {
+                for (uint64_t i = 0; i < n; i++) widget.handleTextInput("x");
+            });
+
+        runner.run("TextWidget erase (middle)", param,
+            [&](uint64_t) { reset(middle); },
+            [&](uint64_t n) {
+                for (uint64_t i = 0; i < n; i++) widget.handleKeyDown("Backspace", false, false);
+            });
+
+        // Undo history is capped, so time at most that many steps per round
+        runner.run("TextWidget undo", param,
+            [&](uint64_t) { reset(middle); },
+            [&](uint64_t n) {
+                for (uint64_t done = 0; done < n;) {
+                    uint64_t batch = std::min<uint64_t>(n - done, 100);
+                    for (uint64_t i = 0; i < batch; i++) widget.handleTextInput("x");
+                    for (uint64_t i = 0; i < batch; i++) widget.handleKeyDown("z", false, true);
+                    done += batch;
+                }
+            });
+
+        reset(0);
+        runner.run("TextWidget getLines", param, [&](uint64_t n) {
+            for (uint64_t i = 0; i < n; i++) BenchRunner::keep(TextWidgetBench::lineCount(widget));
+        });
+    }
+
+    // Hit-testing a click within one line
+    TextWidget widget;
+    widget.init(ctx.renderer, ctx.textEngine, ctx.font, nullptr);
+    for (size_t length : {40, 200}) {
+        std::string line = makeDocument(length * 2).substr(0, length);
+        for (char& c : line) if (c == '\n') c = ' ';
+        runner.run("TextWidget getOffsetFromX", std::to_string(length) + " chars", [&](uint64_t n) {
+            for (uint64_t i = 0; i < n; i++) {
+                float x = static_cast<float>((i * 37) % (length * 8));
+                BenchRunner::keep(TextWidgetBench::offsetFromX(widget, line, x));
+            }
+        });
+    }
+}
+
+void benchFonts(BenchRunner& runner, Context& ctx) {
+    runner.run("FontManager getFont", "same size", [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) BenchRunner::keep(ctx.fonts.getFont(ctx.fontId, 16.0f) != nullptr);
+    });
+
+    const float sizes[] = {12.0f, 14.0f, 16.0f, 18.0f, 20.0f, 24.0f, 32.0f, 48.0f};
+    for (float size : sizes) ctx.fonts.getFont(ctx.fontId, size);
+    runner.run("FontManager getFont", "8 sizes", [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) BenchRunner::keep(ctx.fonts.getFont(ctx.fontId, sizes[i % 8]) != nullptr);
+    });
+
+    // Sizes between buckets quantise onto cached instances
+    runner.run("FontManager getFont", "fractional", [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) {
+            float size = 16.0f + static_cast<float>(i % 10) * 0.05f;
+            BenchRunner::keep(ctx.fonts.getFont(ctx.fontId, size) != nullptr);
+        }
+    });
+}
+
+void benchBindings(BenchRunner& runner, LuaAllocator& allocator) {
+    sol::state lua = allocator.createState();
+    lua.open_libraries(sol::lib::base, sol::lib::package, sol::lib::jit, sol::lib::ffi);
+
+    lua["solAdd"] = [](int a, int b) { return a + b; };
+    lua_pushcfunction(lua.lua_state(), rawAdd);
+    lua_setglobal(lua.lua_state(), "rawAdd");
+
+    // The loops run in Lua so the comparison is the per-call cost as seen
+    // by a script; one outer sol call per sample is amortised away
+    lua.script(R"(
+        local ffi = require("ffi")
+        ffi.cdef[[int bench_add(int a, int b);]]
+        local ffiAdd = ffi.C.bench_add
+        local function luaAdd(a, b) return a + b end
+
+        local function loop(f)
+            return function(n)
+                local s = 0
+                for i = 1, n do s = s + f(i, 1) end
+                return s
+            end
+        end
+
+        benchLoops = {
+            lua = loop(luaAdd),
+            sol = loop(solAdd),
+            raw = loop(rawAdd),
+            ffi = loop(function(a, b) return ffiAdd(a, b) end),
+        }
+    )");
+
+    const char* variants[][2] = {
+        {"lua", "pure Lua"}, {"sol", "sol3 lambda"}, {"raw", "lua_CFunction"}, {"ffi", "LuaJIT FFI"}};
+    for (const auto& variant : variants) {
+        sol::function loop = lua["benchLoops"][variant[0]];
+        runner.run("Lua call add(a, b)", variant[1], [&](uint64_t n) {
+            double sum = loop(static_cast<double>(n));
+            BenchRunner::keep(sum);
+        });
+    }
+}
+
+void benchRendering(BenchRunner& runner, Context& ctx) {
+    Compositor compositor;
+    compositor.init(ctx.renderer, ctx.textEngine, nullptr);
+    const SDL_FColor background = {0.1f, 0.1f, 0.12f, 1.0f};
+    const SDL_Color white = {255, 255, 255, 255};
+
+    // The software renderer batches commands, so each sample ends with a
+    // flush to include the rasterisation
+    runner.run("Compositor fillRect", "immediate", [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) {
+            float x = static_cast<float>((i * 13) % 960), y = static_cast<float>((i * 7) % 700);
+            compositor.fillRect(x, y, 32, 32, SDL_Color{static_cast<Uint8>(i), 128, 200, 255});
+        }
+        SDL_FlushRenderer(ctx.renderer);
+    });
+
+    runner.run("Compositor text", "immediate", [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) {
+            float x = static_cast<float>((i * 13) % 800), y = static_cast<float>((i * 7) % 700);
+            compositor.text(ctx.font, "The quick brown fox", x, y, white);
+        }
+        SDL_FlushRenderer(ctx.renderer);
+    });
+
+    // A static scene of 500 rects: recording plus display-list diffing
+    compositor.setDamageTracking(true);
+    runner.run("Compositor frame (500 rects)", "damage", [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) {
+            compositor.beginFrame(1024, 768, background);
+            for (int r = 0; r < 500; r++) {
+                compositor.fillRect(static_cast<float>((r * 13) % 960), static_cast<float>((r * 7) % 700),
+                                    32, 32, white);
+            }
+            compositor.endFrame();
+        }
+        SDL_FlushRenderer(ctx.renderer);
+    });
+    compositor.cleanup();
+}
+
+bool writeJson(const std::string& path, const BenchRunner& runner, const LuaAllocator::Stats& mem) {
+    SDL_IOStream* io = SDL_IOFromFile(path.c_str(), "w");
+    if (!io) {
+        std::cerr << "Failed to write " << path << ": " << SDL_GetError() << std::endl;
+        return false;
+    }
+    SDL_IOprintf(io, "{\n  \"version\": \"%s\",\n  \"results\": [\n", APP_VERSION);
+    const auto& results = runner.getResults();
+    for (size_t i = 0; i < results.size(); i++) {
+        const auto& r = results[i];
+        SDL_IOprintf(io,
+                     "    {\"name\": \"%s\", \"param\": \"%s\", \"iterations\": %llu, "
+                     "\"nsPerOp\": %.2f, \"minNsPerOp\": %.2f, \"maxNsPerOp\": %.2f}%s\n",
+                     r.name.c_str(), r.param.c_str(), static_cast<unsigned long long>(r.iterations),
+                     r.nsPerOp, r.minNsPerOp, r.maxNsPerOp, i + 1 < results.size() ? "," : "");
+    }
+    SDL_IOprintf(io,
+                 "  ],\n  \"luaAllocator\": {\"pooling\": %s, \"peakBytes\": %zu, \"liveBytes\": %zu, "
+                 "\"pooledBytes\": %zu, \"allocations\": %llu, \"frees\": %llu}\n}\n",
+                 mem.pooling ? "true" : "false", mem.peakBytes, mem.liveBytes, mem.pooledBytes,
+                 static_cast<unsigned long long>(mem.allocations), static_cast<unsigned long long>(mem.frees));
+    SDL_CloseIO(io);
+    std::cout << "Wrote " << results.size() << " results to " << path << std::endl;
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    BenchRunner runner;
+    std::string jsonPath;
+    std::string fontPath = std::string(BENCH_ASSET_DIR) + "/DejaVuSans.ttf";
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--filter" && i + 1 < argc) {
+            runner.filter = argv[++i];
+        } else if (arg == "--json" && i + 1 < argc) {
+            jsonPath = argv[++i];
+        } else if (arg == "--font" && i + 1 < argc) {
+            fontPath = argv[++i];
+        } else if (arg == "--quick") {
+            runner.minSampleMs = 5.0;
+            runner.samples = 3;
+        } else {
+            std::cerr << "Usage: bench [--filter <substring>] [--json <file>] [--quick] [--font <file>]" << std::endl;
+            return 1;
+        }
+    }
+
+    if (!SDL_Init(0)) {
+        std::cerr << "SDL_Init failed: " << SDL_GetError() << std::endl;
+        return 1;
+    }
+    if (!TTF_Init()) {
+        std::cerr << "TTF_Init failed: " << SDL_GetError() << std::endl;
+        SDL_Quit();
+        return 1;
+    }
+
+    // Offscreen software renderer: no window or GPU needed
+    Context ctx;
+    ctx.surface = SDL_CreateSurface(1024, 768, SDL_PIXELFORMAT_ARGB8888);
+    ctx.renderer = ctx.surface ? SDL_CreateSoftwareRenderer(ctx.surface) : nullptr;
+    ctx.textEngine = ctx.renderer ? TTF_CreateRendererTextEngine(ctx.renderer) : nullptr;
+    if (ctx.textEngine) {
+        ctx.fontId = ctx.fonts.loadFont(fontPath, 16.0f);
+        ctx.font = ctx.fontId >= 0 ? ctx.fonts.getFont(ctx.fontId, 16.0f) : nullptr;
+    }
+    if (!ctx.font) {
+        std::cerr << "Failed to set up the software renderer or load " << fontPath << ": " << SDL_GetError() << std::endl;
+        return 1;
+    }
+
+    LuaAllocator allocator;
+
+    std::cout << "bench " << APP_VERSION << std::endl;
+    runner.printHeader();
+    benchTextWidget(runner, ctx);
+    benchFonts(runner, ctx);
+    benchBindings(runner, allocator);
+    benchRendering(runner, ctx);
+
+    // Allocator figures from the binding benchmarks' Lua state
+    LuaAllocator::Stats mem = allocator.getStats();
+    std::cout << "\nLua allocator (" << (mem.pooling ? "pooled" : "fallback") << "): peak "
+              << mem.peakBytes / 1024 << " KB, pooled " << mem.pooledBytes / 1024 << " KB, "
+              << mem.allocations << " allocations, " << mem.frees << " frees" << std::endl;
+
+    bool ok = jsonPath.empty() || writeJson(jsonPath, runner, mem);
+
+    ctx.fonts.cleanup();
+    TTF_DestroyRendererTextEngine(ctx.textEngine);
+    SDL_DestroyRenderer(ctx.renderer);
+    SDL_DestroySurface(ctx.surface);
+    TTF_Quit();
+    SDL_Quit();
+    return ok ? 0 : 1;
+}
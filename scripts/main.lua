@@ -51,9 +51,9 @@ end
 -- Render function called every frame (global for C++ callback)
 ---@diagnostic disable-next-line: lowercase-global
 function render()
-    local winSize = getWindowSize()
-    local centerX = winSize.width / 2
-    local centerY = winSize.height / 2
+    local winWidth, winHeight = getWindowDimensions()
+    local centerX = winWidth / 2
+    local centerY = winHeight / 2
 
     -- Draw animated rectangles
     for i = 1, 5 do
@@ -88,14 +88,14 @@ function render()
     -- Draw title and info text
     if font then
         setFontSize(32)
-        drawText("SDL3 + Lua Demo", 10, winSize.height - 80, 1.0, 0.9, 0.3)
+        drawText("SDL3 + Lua Demo", 10, winHeight - 80, 1.0, 0.9, 0.3)
         setFontSize(18)
         local fpsText = string.format("Time: %.1fs", time)
-        drawText(fpsText, 10, winSize.height - 40, 0.8, 0.8, 0.8)
+        drawText(fpsText, 10, winHeight - 40, 0.8, 0.8, 0.8)
 
         -- Show text measurement
-        local measure = measureText("SDL3 + Lua Demo")
-        drawText("Title width: " .. measure.width .. "px", 10, winSize.height - 20, 0.6, 0.6, 0.6)
+        local titleWidth = measureTextSize("SDL3 + Lua Demo")
+        drawText("Title width: " .. titleWidth .. "px", 10, winHeight - 20, 0.6, 0.6, 0.6)
     end
 end
 
@@ -0,0 +1,251 @@
+-- Stress scenes for scaling profiles (run headless, see README "Stress Runs")
+--
+--   SDL3_Lua_Sol3 scripts/stress.lua --headless --frame-csv=stress.csv \
+--       --thresholds=scripts/stress_thresholds.txt scene=rects sizes=100,1000
+--
+-- Arguments (key=value):
+--   scene    rects | labels | widgets | text | events | all (default all)
+--   sizes    comma-separated N for the chosen scene (default per scene)
+--   frames   recorded frames per N (default 120)
+--   warmup   frames run before recording each N (default 10)
+--   textkb   KB of text per widget in the widgets scene (default 1)
+--   widgets  widget count in the text scene (default 4)
+--   events   extra synthetic events per frame in every scene (default 0)
+--
+-- Scenes scale one dimension each:
+--   rects    N filled rectangles
+--   labels   N text labels
+--   widgets  N text widgets holding textkb KB each
+--   text     N KB of text in each of `widgets` multiline widgets
+--   events   N synthetic input events per frame into a focused widget
+
+---@diagnostic disable: undefined-global
+
+local options = {
+    scene = "all",
+    frames = 120,
+    warmup = 10,
+    textkb = 1,
+    widgets = 4,
+    events = 0,
+}
+for i = 1, #arg do
+    local key, value = arg[i]:match("^(%w+)=(.*)$")
+    if not key then
+        error("stress.lua: expected key=value, got '" .. arg[i] .. "'")
+    end
+    options[key] = tonumber(value) or value
+end
+
+local defaultSizes = {
+    rects = {100, 1000, 10000, 50000},
+    labels = {10, 100, 1000, 5000},
+    widgets = {1, 10, 100, 500},
+    text = {1, 16, 64, 256},
+    events = {1, 10, 100, 1000},
+}
+local sceneOrder = {"rects", "labels", "widgets", "text", "events"}
+
+local function parseSizes(text)
+    local sizes = {}
+    for value in tostring(text):gmatch("[^,]+") do
+        sizes[#sizes + 1] = tonumber(value)
+    end
+    return sizes
+end
+
+loadFont("assets/DejaVuSans.ttf", 14)
+setWindowTitle("Stress")
+if not isHeadless() then
+    print("stress.lua: not headless; the 'frame' metric includes frame pacing")
+end
+
+-- ~60 column lines of filler text
+local function makeText(kilobytes)
+    local line = "The quick brown fox jumps over the lazy dog 0123456789 abc\n"
+    local bytes = math.floor(kilobytes * 1024)
+    return string.rep(line, math.ceil(bytes / #line)):sub(1, bytes)
+end
+
+local function createWidgetGrid(count, text, width, height, multiline)
+    local winWidth, winHeight = getWindowDimensions()
+    local columns = math.max(1, math.floor(winWidth / width))
+    local rows = math.max(1, math.floor(winHeight / height))
+    local list = {}
+    for i = 0, count - 1 do
+        local cell = i % (columns * rows)
+        local widget = createTextWidget({
+            x = (cell % columns) * width,
+            y = math.floor(cell / columns) * height,
+            width = width - 4,
+            height = height - 4,
+            multiline = multiline,
+        })
+        widget:setText(text)
+        list[#list + 1] = widget
+    end
+    return list
+end
+
+local function destroyWidgets(list)
+    for _, widget in ipairs(list) do
+        widget:destroy()
+    end
+end
+
+-- Cycle of synthetic input aimed at a rectangle: hover, click, drag, type, erase
+local function pushInput(count, x, y, w, h, frame)
+    for i = 1, count do
+        local k = frame * count + i
+        local px = x + (k * 37) % w
+        local py = y + (k * 11) % h
+        local step = k % 6
+        if step == 0 then
+            pushEvent("mousemotion", {x = px, y = py})
+        elseif step == 1 then
+            pushEvent("mousedown", {x = px, y = py, button = 1})
+        elseif step == 2 then
+            pushEvent("mousemotion", {x = px + 20, y = py})
+        elseif step == 3 then
+            pushEvent("mouseup", {x = px + 20, y = py, button = 1})
+        elseif step == 4 then
+            pushEvent("textinput", {text = "a"})
+        else
+            pushEvent("keydown", {key = "Backspace"})
+        end
+    end
+end
+
+local scenes = {}
+
+scenes.rects = {
+    setup = function(self, n)
+        self.n = n
+    end,
+    render = function(self, frame)
+        local winWidth, winHeight = getWindowDimensions()
+        for i = 1, self.n do
+            local x = (i * 13 + frame) % winWidth
+            local y = (i * 7) % winHeight
+            drawRect(x, y, 16, 16, (i % 7) / 7, (i % 5) / 5, 0.6, 1.0)
+        end
+    end,
+}
+
+scenes.labels = {
+    setup = function(self, n)
+        self.labels = {}
+        for i = 1, n do
+            self.labels[i] = "Label " .. i
+        end
+    end,
+    render = function(self, frame)
+        local winWidth, winHeight = getWindowDimensions()
+        for i, label in ipairs(self.labels) do
+            local x = (i * 97 + frame) % winWidth
+            local y = (i * 17) % winHeight
+            drawText(label, x, y, 0.9, 0.9, 0.9)
+        end
+    end,
+    teardown = function(self)
+        self.labels = nil
+    end,
+}
+
+scenes.widgets = {
+    setup = function(self, n)
+        self.widgets = createWidgetGrid(n, makeText(options.textkb), 160, 40, false)
+    end,
+    teardown = function(self)
+        destroyWidgets(self.widgets)
+    end,
+}
+
+scenes.text = {
+    setup = function(self, n)
+        self.widgets = createWidgetGrid(options.widgets, makeText(n), 400, 300, true)
+    end,
+    teardown = function(self)
+        destroyWidgets(self.widgets)
+    end,
+}
+
+scenes.events = {
+    setup = function(self, n)
+        self.n = n
+        self.widgets = createWidgetGrid(1, makeText(4), 600, 400, true)
+        self.widgets[1]:setFocus(true)
+    end,
+    update = function(self, frame)
+        pushInput(self.n, 10, 10, 580, 380, frame)
+    end,
+    teardown = function(self)
+        destroyWidgets(self.widgets)
+    end,
+}
+
+-- Build the plan: one step per (scene, N)
+local plan = {}
+for _, name in ipairs(sceneOrder) do
+    if options.scene == "all" or options.scene == name then
+        local sizes = options.sizes and options.scene ~= "all" and parseSizes(options.sizes) or defaultSizes[name]
+        for _, n in ipairs(sizes) do
+            plan[#plan + 1] = {scene = name, n = n}
+        end
+    end
+end
+if #plan == 0 then
+    error("stress.lua: unknown scene '" .. tostring(options.scene) .. "'")
+end
+
+local stepIndex = 0
+local scene = nil
+local frame = 0
+
+local function nextStep()
+    if scene and scene.teardown then
+        scene:teardown()
+    end
+    stepIndex = stepIndex + 1
+    local step = plan[stepIndex]
+    if not step then
+        scene = nil
+        quit(0)
+        return
+    end
+    print(string.format("stress: %s n=%d", step.scene, step.n))
+    scene = scenes[step.scene]
+    scene:setup(step.n)
+    frame = 0
+end
+
+nextStep()
+
+---@diagnostic disable-next-line: lowercase-global
+function update(deltaTime)
+    if not scene then return end
+    frame = frame + 1
+
+    local step = plan[stepIndex]
+    if frame == options.warmup + 1 then
+        beginFrameSeries(step.scene, step.n)
+    elseif frame > options.warmup + options.frames then
+        endFrameSeries()
+        nextStep()
+        if not scene then return end
+    end
+
+    if scene.update then
+        scene:update(frame)
+    end
+    if options.events > 0 then
+        pushInput(options.events, 0, 0, 400, 300, frame)
+    end
+end
+
+---@diagnostic disable-next-line: lowercase-global
+function render()
+    if scene and scene.render then
+        scene:render(frame)
+    end
+end
@@ -46,11 +46,8 @@ local readOnly = createTextWidget({
 })
 readOnly:setText("Read-only text (cannot edit)")
 
-function update(dt)
-    singleLine:update(dt)
-    multiLine:update(dt)
-    readOnly:update(dt)
-end
+-- Widgets are updated and rendered natively by the application every frame;
+-- Lua only draws the surrounding labels.
 
 function render()
     local winSize = getWindowSize()
@@ -65,11 +62,6 @@ function render()
     drawText("Multi-line input:", 50, 105, 0.7, 0.7, 0.7)
     drawText("Read-only:", 50, 285, 0.7, 0.7, 0.7)
 
-    -- Render widgets
-    singleLine:render()
-    multiLine:render()
-    readOnly:render()
-
     -- Instructions
     local y = 360
     drawText("Instructions:", 50, y, 0.6, 0.8, 0.6); y = y + 20
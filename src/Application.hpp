@@ -4,13 +4,32 @@
 #include <SDL3/SDL.h>
 #include <SDL3_ttf/SDL_ttf.h>
 #include <sol/sol.hpp>
-#include <map>
+#include <deque>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "widgets/TextWidget.hpp"
+#include "widgets/WidgetRegistry.hpp"
 #include "graphics/FontManager.hpp"
+#include "graphics/RenderCache.hpp"
+#include "graphics/Compositor.hpp"
+#include "graphics/GlyphAtlas.hpp"
+#include "graphics/TextLayout.hpp"
+#include "graphics/PerfOverlay.hpp"
+#include "assets/AssetLoader.hpp"
 #include "events/EventHandler.hpp"
+#include "events/InputRecorder.hpp"
+#include "layout/LayoutNode.hpp"
+#include "lua/AllocationTracker.hpp"
+#include "lua/LuaAllocator.hpp"
+#include "lua/GcScheduler.hpp"
+#include "lua/LuaProfiler.hpp"
+#include "lua/JitDiagnostics.hpp"
+#include "lua/ScriptWatchdog.hpp"
+#include "core/FrameStats.hpp"
+#include "core/FrameRecorder.hpp"
+#include "core/LatencyTracker.hpp"
 
 // Forward declaration for friend class
 class LuaBindings;
@@ -23,6 +42,16 @@ private:
     SDL_Window* window = nullptr;
     SDL_Renderer* renderer = nullptr;
     bool running = true;
+    int exitCode = 0;
+
+    // Headless runs: offscreen video driver, software renderer, no frame
+    // pacing; frameLimit > 0 quits after that many frames
+    bool headless = false;
+    Uint64 frameLimit = 0;
+    float fixedDeltaTime = 0.0f;     // Seconds per frame when > 0 (replays)
+
+    // Pooled Lua heap with an optional cap (declared first: outlives the state)
+    LuaAllocator luaAllocator;
     sol::state lua;
 
     int windowWidth = 800;
@@ -35,9 +64,79 @@ private:
     // Font management
     FontManager fontManager;
 
-    // TextWidget management
-    std::map<int, std::shared_ptr<TextWidget>> textWidgets;
-    int nextWidgetId = 1;
+    // Cached paragraph layouts (layoutText) and string measurements
+    TextLayoutCache textLayouts;
+    TextMeasureCache textMeasures;
+
+    // Optional on-disk glyph atlases for simple text draws
+    GlyphAtlasCache glyphAtlases;
+
+    // Background font/asset loading (finished on the main thread in update)
+    AssetLoader assetLoader;
+
+    // Resumes coroutines started with runAsync (set up by LuaBindings)
+    sol::protected_function resumeAsyncTasks;
+
+    // Cached widget textures (redrawn only when a widget changes)
+    RenderCache renderCache;
+
+    // All drawing goes through the compositor (immediate or damage-tracked)
+    Compositor compositor;
+
+    // TextWidget management (generational slot map, see core/SlotMap.hpp)
+    TextWidgetRegistry textWidgets;
+
+    // Native widget passes: widgets are updated and drawn by the application,
+    // in zOrder, without a Lua call per widget
+    std::vector<SlotHandle> widgetDrawOrder;
+    bool widgetDrawOrderDirty = true;
+    Uint64 frameCounter = 0;
+
+    // Retained layout tree positioning widgets (optional, set from Lua)
+    std::shared_ptr<LayoutNode> rootLayout;
+
+    // Lua GC runs in frame slack time (see GcScheduler)
+    GcScheduler gcScheduler;
+
+    // Optional time budget per Lua callback (off unless set from Lua)
+    ScriptWatchdog scriptWatchdog;
+
+    // Timings of the last completed frame
+    FrameStats frameStats;
+    FrameStats currentFrame;
+
+    // Event timestamp to SDL_RenderPresent, per event type
+    LatencyTracker inputLatency;
+
+    // Frame-time graph and counters (F3 or setPerfOverlay)
+    PerfOverlay perfOverlay;
+
+    // Per-scene frame series for stress runs (--frame-csv, --thresholds)
+    FrameRecorder frameRecorder;
+    std::string frameCsvOutput;
+    std::string thresholdsPath;
+
+    // Text of events pushed from Lua, kept alive until they are handled
+    std::deque<std::string> syntheticText;
+
+    // Input capture and deterministic replay (--record, --replay)
+    InputRecorder inputRecorder;
+    std::string inputRecordOutput;   // Written at exit when recording from startup
+
+    // Sampling profiler (--profile or startProfiler from Lua)
+    LuaProfiler profiler;
+    std::string profileOutput;       // Written at exit when profiling from startup
+    std::string traceOutput;         // Trace-event JSON written at exit (--trace)
+
+    // JIT trace aborts per function and binding (--jit-report or setJitDiagnostics)
+    JitDiagnostics jitDiagnostics;
+    bool printJitReport = false;
+
+    // Global functions registered by LuaBindings (for the diagnostics above)
+    std::vector<std::string> bindingNames;
+
+    // Debug: per-binding Lua allocation counts (off unless enabled from Lua)
+    AllocationTracker allocationTracker;
 
     // Event handling
     std::unique_ptr<EventHandler> eventHandler;
@@ -48,10 +147,29 @@ public:
 
     bool initialize();
     bool loadScript(const std::string& scriptPath);
+    void startProfiling(const std::string& outputPath);
+    void enableJitReport();
+    void startTracing(const std::string& outputPath);
+    void setHeadless(bool enabled, Uint64 maxFrames = 0);
+    void setScriptArgs(const std::vector<std::string>& args);
+    void recordFrameSeries(const std::string& csvPath, const std::string& thresholds);
+    void startInputRecording(const std::string& outputPath);
+    bool startReplay(const std::string& inputPath);
     void update(float deltaTime);
     void render();
     void run();
+    // Writes stress-run results; returns the process exit code
+    int finishRun();
     void cleanup();
+
+private:
+    // Native widget passes (skip widgets Lua already drove this frame)
+    void updateWidgets(float deltaTime);
+    void renderWidgets();
+    void rebuildWidgetDrawOrder();
+
+    // Re-run layout for dirty subtrees of the root layout (no-op when clean)
+    void updateLayout();
 };
 
 #endif // APPLICATION_HPP
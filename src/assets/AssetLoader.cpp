@@ -0,0 +1,187 @@
+#include "AssetLoader.hpp"
+#include "../graphics/FontManager.hpp"
+#include "../core/Trace.hpp"
+#include "../core/Log.hpp"
+#include <algorithm>
+
+AssetLoader::~AssetLoader() {
+    stop();
+}
+
+void AssetLoader::start(FontManager* fonts, int threadCount) {
+    fontManager = fonts;
+    if (!workers.empty()) return;
+
+    if (threadCount <= 0) {
+        // Leave a core for the main thread; file I/O rarely benefits from more
+        threadCount = std::clamp(SDL_GetNumLogicalCPUCores() - 1, 1, 4);
+    }
+
+    stopping = false;
+    for (int i = 0; i < threadCount; i++) {
+        workers.emplace_back(&AssetLoader::workerLoop, this);
+    }
+}
+
+std::shared_ptr<AssetLoader::Job> AssetLoader::loadFont(const std::string& path, float size) {
+    auto job = std::make_shared<Job>();
+    job->id = nextId++;
+    job->kind = AssetKind::Font;
+    job->path = path;
+    // Open at the size the font cache will file it under
+    job->size = fontManager ? fontManager->quantiseSize(size) : size;
+    inFlight.push_back(job);
+
+    if (workers.empty()) {
+        // No pool (not started or already stopped): decode inline, finish in pump()
+        decode(*job);
+        std::lock_guard<std::mutex> lock(mutex);
+        finished.push_back(job);
+        return job;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.push_back(job);
+    }
+    workAvailable.notify_one();
+    return job;
+}
+
+void AssetLoader::onComplete(const std::shared_ptr<Job>& job, std::function<void(const Job&)> callback) {
+    if (job->isDone()) {
+        callback(*job);
+        return;
+    }
+    job->callbacks.push_back(std::move(callback));
+}
+
+void AssetLoader::pump() {
+    TRACE_ZONE("AssetLoader::pump");
+    std::vector<std::shared_ptr<Job>> ready;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (finished.empty()) return;
+        ready.swap(finished);
+    }
+
+    for (auto& job : ready) {
+        complete(*job);
+    }
+}
+
+void AssetLoader::wait(const std::shared_ptr<Job>& job) {
+    while (!job->isDone()) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            workFinished.wait(lock, [this]() { return !finished.empty() || stopping; });
+            if (stopping && finished.empty()) return;
+        }
+        pump();
+    }
+}
+
+void AssetLoader::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        queue.clear();
+    }
+    workAvailable.notify_all();
+    workFinished.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    workers.clear();
+
+    // Release whatever was decoded but never handed to the main thread
+    for (auto& job : inFlight) {
+        if (job->font) {
+            TTF_CloseFont(job->font);
+            job->font = nullptr;
+        }
+        SDL_free(job->data);
+        job->data = nullptr;
+        if (!job->isDone()) {
+            job->state = AssetState::Failed;
+            job->error = "Asset loader stopped";
+        }
+        job->callbacks.clear();
+    }
+    inFlight.clear();
+    finished.clear();
+}
+
+void AssetLoader::workerLoop() {
+    trace::setThreadName("AssetLoader");
+    for (;;) {
+        std::shared_ptr<Job> job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            workAvailable.wait(lock, [this]() { return stopping || !queue.empty(); });
+            if (stopping) return;
+            job = std::move(queue.front());
+            queue.pop_front();
+        }
+
+        decode(*job);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            finished.push_back(std::move(job));
+        }
+        workFinished.notify_all();
+    }
+}
+
+void AssetLoader::decode(Job& job) {
+    TRACE_ZONE("AssetLoader::decode");
+    switch (job.kind) {
+    case AssetKind::Font: {
+        job.data = SDL_LoadFile(job.path.c_str(), &job.dataSize);
+        if (!job.data) {
+            job.workerError = SDL_GetError();
+            return;
+        }
+        job.fileHash = FontManager::hashFileData(job.data, job.dataSize);
+        // Parsing the face happens here too; SDL_ttf allows opening fonts
+        // from any thread. The buffer outlives the font (see FontManager)
+        SDL_IOStream* stream = SDL_IOFromConstMem(job.data, job.dataSize);
+        job.font = stream ? TTF_OpenFontIO(stream, true, job.size) : nullptr;
+        if (!job.font) {
+            job.workerError = SDL_GetError();
+            SDL_free(job.data);
+            job.data = nullptr;
+        }
+        break;
+    }
+    }
+}
+
+void AssetLoader::complete(Job& job) {
+    switch (job.kind) {
+    case AssetKind::Font:
+        if (job.font && fontManager) {
+            job.fontId = fontManager->adoptFont(job.path, job.data, job.dataSize, job.fileHash,
+                                                job.font, job.size);
+            job.data = nullptr;
+            job.font = nullptr;
+            job.state = AssetState::Ready;
+        } else {
+            job.state = AssetState::Failed;
+            job.error = job.workerError.empty() ? "No font manager" : job.workerError;
+            logging::error("Failed to load font: ", job.path, " - ", job.error);
+        }
+        break;
+    }
+
+    inFlight.erase(std::remove_if(inFlight.begin(), inFlight.end(),
+        [&job](const std::shared_ptr<Job>& j) { return j.get() == &job; }), inFlight.end());
+
+    // Callbacks may queue more work or drop the last reference to the job
+    auto callbacks = std::move(job.callbacks);
+    job.callbacks.clear();
+    for (auto& callback : callbacks) {
+        callback(job);
+    }
+}
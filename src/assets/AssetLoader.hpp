@@ -0,0 +1,104 @@
+#ifndef ASSETLOADER_HPP
+#define ASSETLOADER_HPP
+
+#include <SDL3/SDL.h>
+#include <SDL3_ttf/SDL_ttf.h>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Forward declaration
+class FontManager;
+
+// Background asset loader.
+//
+// Worker threads read asset files and decode them into memory; the main
+// thread finishes each asset in pump() (registering it with the owning
+// manager) and then runs its completion callbacks. Requests return a shared
+// Job that can be polled, waited on or given callbacks.
+class AssetLoader {
+public:
+    enum class AssetKind { Font };
+    enum class AssetState { Pending, Ready, Failed };
+
+    struct Job {
+        // Request (immutable once queued)
+        uint64_t id = 0;
+        AssetKind kind = AssetKind::Font;
+        std::string path;
+        float size = 0.0f;
+
+        // Main thread only
+        AssetState state = AssetState::Pending;
+        int fontId = -1;
+        std::string error;
+        std::vector<std::function<void(const Job&)>> callbacks;
+
+        bool isDone() const { return state != AssetState::Pending; }
+
+    private:
+        friend class AssetLoader;
+
+        // Written by the worker, handed to the main thread through `finished`
+        void* data = nullptr;
+        size_t dataSize = 0;
+        uint64_t fileHash = 0;
+        TTF_Font* font = nullptr;
+        std::string workerError;
+    };
+
+private:
+    FontManager* fontManager = nullptr;
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable workAvailable;
+    std::condition_variable workFinished;
+    std::deque<std::shared_ptr<Job>> queue;      // Waiting for a worker
+    std::vector<std::shared_ptr<Job>> finished;  // Decoded, waiting for pump()
+    bool stopping = false;
+
+    // Main thread only: jobs not yet completed (keeps them alive without Lua refs)
+    std::vector<std::shared_ptr<Job>> inFlight;
+    uint64_t nextId = 1;
+
+public:
+    AssetLoader() = default;
+    ~AssetLoader();
+
+    AssetLoader(const AssetLoader&) = delete;
+    AssetLoader& operator=(const AssetLoader&) = delete;
+
+    // Start the worker pool (threadCount <= 0 picks one from the CPU count)
+    void start(FontManager* fonts, int threadCount = 0);
+
+    // Queue a font file to be read and opened at `size` off the main thread
+    std::shared_ptr<Job> loadFont(const std::string& path, float size);
+
+    // Run a callback once the job completes (immediately if it already has)
+    void onComplete(const std::shared_ptr<Job>& job, std::function<void(const Job&)> callback);
+
+    // Main thread: finish decoded jobs and run their callbacks
+    void pump();
+
+    // Main thread: block until the job completes
+    void wait(const std::shared_ptr<Job>& job);
+
+    size_t pendingCount() const { return inFlight.size(); }
+
+    // Join the workers and drop unfinished jobs (callbacks are not run)
+    void stop();
+
+private:
+    void workerLoop();
+    static void decode(Job& job);
+    void complete(Job& job);
+};
+
+#endif // ASSETLOADER_HPP
@@ -0,0 +1,119 @@
+#include "FrameRecorder.hpp"
+#include "Log.hpp"
+#include <SDL3/SDL.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstdio>
+#include <sstream>
+
+void FrameRecorder::begin(const std::string& scene, int n) {
+    series.push_back(Series{scene, n, {}});
+    recording = true;
+}
+
+void FrameRecorder::record(const FrameStats& stats) {
+    if (!recording || series.empty()) return;
+    series.back().frames.push_back(stats);
+}
+
+double FrameRecorder::metric(const FrameStats& stats, const std::string& name) {
+    if (name == "update") return stats.updateMs;
+    if (name == "render") return stats.renderMs;
+    if (name == "present") return stats.presentMs;
+    if (name == "gc") return stats.gcMs;
+    if (name == "work") return stats.updateMs + stats.renderMs + stats.presentMs + stats.gcMs;
+    if (name == "frame") return stats.frameMs;
+    return -1.0;
+}
+
+double FrameRecorder::percentile(const Series& s, const std::string& metricName, double p) {
+    if (s.frames.empty()) return 0.0;
+    std::vector<double> values;
+    values.reserve(s.frames.size());
+    for (const FrameStats& frame : s.frames) {
+        values.push_back(metric(frame, metricName));
+    }
+    std::sort(values.begin(), values.end());
+    size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * values.size()));
+    return values[std::min(std::max<size_t>(rank, 1), values.size()) - 1];
+}
+
+bool FrameRecorder::writeCsv(const std::string& path) const {
+    SDL_IOStream* io = SDL_IOFromFile(path.c_str(), "w");
+    if (!io) {
+        logging::error("Failed to write frame series ", path, ": ", SDL_GetError());
+        return false;
+    }
+    SDL_IOprintf(io, "scene,n,frame,update_ms,render_ms,present_ms,gc_ms,work_ms,frame_ms,"
+                     "gc_steps,draw_calls,text_objects,events\n");
+    for (const Series& s : series) {
+        for (size_t i = 0; i < s.frames.size(); i++) {
+            const FrameStats& f = s.frames[i];
+            SDL_IOprintf(io, "%s,%d,%zu,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%u,%u,%u,%u\n",
+                         s.scene.c_str(), s.n, i, f.updateMs, f.renderMs, f.presentMs, f.gcMs,
+                         metric(f, "work"), f.frameMs, f.gcSteps, f.drawCalls, f.textObjects, f.events);
+        }
+    }
+    SDL_CloseIO(io);
+    logging::info("Wrote ", series.size(), " frame series to ", path);
+    return true;
+}
+
+void FrameRecorder::printSummary() const {
+    std::printf("%-12s %8s %7s %9s %9s %9s %9s\n", "scene", "n", "frames", "p50 ms", "p95 ms", "p99 ms", "max ms");
+    for (const Series& s : series) {
+        std::printf("%-12s %8d %7zu %9.3f %9.3f %9.3f %9.3f\n", s.scene.c_str(), s.n, s.frames.size(),
+                    percentile(s, "work", 50), percentile(s, "work", 95),
+                    percentile(s, "work", 99), percentile(s, "work", 100));
+    }
+    std::fflush(stdout);
+}
+
+bool FrameRecorder::checkThresholds(const std::string& path) const {
+    size_t size = 0;
+    char* data = static_cast<char*>(SDL_LoadFile(path.c_str(), &size));
+    if (!data) {
+        logging::error("Failed to read thresholds ", path, ": ", SDL_GetError());
+        return false;
+    }
+    std::istringstream in(std::string(data, size));
+    SDL_free(data);
+
+    bool passed = true;
+    int rules = 0;
+    std::string line;
+    for (int lineNumber = 1; std::getline(in, line); lineNumber++) {
+        line = line.substr(0, line.find('#'));
+        std::istringstream fields(line);
+        std::string scene, n, metricName, pct;
+        double limitMs = 0.0;
+        if (!(fields >> scene)) continue;  // Blank or comment
+        if (!(fields >> n >> metricName >> pct >> limitMs) || pct.size() < 2 || pct[0] != 'p' ||
+            metric(FrameStats{}, metricName) < 0.0) {
+            logging::error(path, ":", lineNumber, ": expected \"scene n metric pNN max_ms\"");
+            passed = false;
+            continue;
+        }
+        double p = pct == "pmax" ? 100.0 : std::atof(pct.c_str() + 1);
+        rules++;
+
+        bool matched = false;
+        for (const Series& s : series) {
+            if ((scene != "*" && s.scene != scene) || (n != "*" && std::to_string(s.n) != n)) continue;
+            matched = true;
+            double value = percentile(s, metricName, p);
+            if (value > limitMs) {
+                logging::error("REGRESSION ", s.scene, " n=", s.n, " ", metricName, " ", pct,
+                               " = ", value, " ms (limit ", limitMs, " ms)");
+                passed = false;
+            }
+        }
+        if (!matched) {
+            logging::warn(path, ":", lineNumber, ": no series ", scene, " n=", n, " was recorded");
+        }
+    }
+
+    logging::info("Checked ", rules, " thresholds: ", (passed ? "passed" : "FAILED"));
+    return passed;
+}
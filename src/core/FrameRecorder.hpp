@@ -0,0 +1,60 @@
+#ifndef FRAMERECORDER_HPP
+#define FRAMERECORDER_HPP
+
+#include <string>
+#include <vector>
+
+#include "FrameStats.hpp"
+
+// Collects FrameStats into named series (e.g. scene "rects" at N = 1000) for
+// stress runs. Scripts open a series with beginFrameSeries(scene, n); every
+// completed frame is added until the next series or endFrameSeries().
+//
+// writeCsv dumps one row per frame, and checkThresholds fails the run when a
+// percentile of a series is above its limit. Threshold files hold one rule
+// per line, '#' starts a comment:
+//
+//     # scene   n     metric  percentile  max_ms
+//     rects     1000  work    p95         8.0
+//     labels    *     frame   p99         16.7
+//     *         *     gc      p99         4.0
+//
+// '*' matches any scene or N. Metrics are update, render, present, gc, work
+// (their sum) and frame (including the pacing delay, which headless runs skip).
+class FrameRecorder {
+public:
+    struct Series {
+        std::string scene;
+        int n = 0;
+        std::vector<FrameStats> frames;
+    };
+
+private:
+    std::vector<Series> series;
+    bool recording = false;
+
+public:
+    void begin(const std::string& scene, int n);
+    void end() { recording = false; }
+    bool isRecording() const { return recording; }
+
+    void record(const FrameStats& stats);
+
+    const std::vector<Series>& getSeries() const { return series; }
+
+    bool writeCsv(const std::string& path) const;
+
+    // p50/p95/p99/max of the work time per series, on stdout
+    void printSummary() const;
+
+    // Returns false if any rule is exceeded (or the file is unreadable)
+    bool checkThresholds(const std::string& path) const;
+
+    // Metric by name (see above); negative for an unknown name
+    static double metric(const FrameStats& stats, const std::string& name);
+
+    // Nearest-rank percentile (0-100) of a metric over a series
+    static double percentile(const Series& s, const std::string& metricName, double p);
+};
+
+#endif // FRAMERECORDER_HPP
@@ -0,0 +1,34 @@
+#ifndef FRAMESTATS_HPP
+#define FRAMESTATS_HPP
+
+#include <cstdint>
+
+// Timings of one frame of Application::run, in milliseconds
+struct FrameStats {
+    double updateMs = 0.0;     // Events and the Lua update callback
+    double renderMs = 0.0;     // Lua render callbacks, widgets and compositing
+    double presentMs = 0.0;    // SDL_RenderPresent
+    double gcMs = 0.0;         // Lua GC steps run by the scheduler
+    double frameMs = 0.0;      // Whole frame, including the pacing delay
+    uint32_t gcSteps = 0;
+    bool gcForced = false;     // Heap was past the force threshold
+    uint32_t drawCalls = 0;    // See frameCounters
+    uint32_t textObjects = 0;
+    uint32_t events = 0;
+};
+
+// Counters bumped by the draw and event paths during a frame (main thread
+// only); Application::run resets them and copies them into FrameStats
+namespace frameCounters {
+inline uint32_t drawCalls = 0;     // Renderer draw calls issued for the scene
+inline uint32_t textObjects = 0;   // TTF_Text objects created
+inline uint32_t events = 0;        // SDL events handled
+
+inline void reset() {
+    drawCalls = 0;
+    textObjects = 0;
+    events = 0;
+}
+} // namespace frameCounters
+
+#endif // FRAMESTATS_HPP
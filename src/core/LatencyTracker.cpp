@@ -0,0 +1,90 @@
+#include "LatencyTracker.hpp"
+#include <algorithm>
+#include <cstdio>
+
+int LatencyTracker::typeOf(Uint32 eventType) {
+    switch (eventType) {
+        case SDL_EVENT_KEY_DOWN: return KeyDown;
+        case SDL_EVENT_KEY_UP: return KeyUp;
+        case SDL_EVENT_TEXT_INPUT: return TextInput;
+        case SDL_EVENT_MOUSE_BUTTON_DOWN: return MouseDown;
+        case SDL_EVENT_MOUSE_BUTTON_UP: return MouseUp;
+        case SDL_EVENT_MOUSE_MOTION: return MouseMotion;
+        case SDL_EVENT_MOUSE_WHEEL: return Wheel;
+        case SDL_EVENT_FINGER_DOWN: return TouchDown;
+        case SDL_EVENT_FINGER_UP: return TouchUp;
+        case SDL_EVENT_FINGER_MOTION: return TouchMotion;
+        default: return -1;
+    }
+}
+
+const char* LatencyTracker::typeName(int type) {
+    static const char* names[TYPE_COUNT] = {"keydown", "keyup", "textinput", "mousedown", "mouseup",
+                                            "mousemotion", "wheel", "touchdown", "touchup", "touchmotion"};
+    return names[type];
+}
+
+void LatencyTracker::eventHandled(Uint32 eventType, Uint64 timestampNs) {
+    int type = typeOf(eventType);
+    if (type < 0 || timestampNs == 0) return;
+    pending.emplace_back(static_cast<Type>(type), timestampNs);
+}
+
+void LatencyTracker::presented(Uint64 presentNs) {
+    for (const auto& [type, timestampNs] : pending) {
+        Samples& s = samples[type];
+        float ms = presentNs > timestampNs ? (presentNs - timestampNs) / 1e6f : 0.0f;
+        if (s.ms.size() < WINDOW) {
+            s.ms.push_back(ms);
+        } else {
+            s.ms[s.next] = ms;
+        }
+        s.next = (s.next + 1) % WINDOW;
+        s.count++;
+    }
+    pending.clear();
+}
+
+std::vector<LatencyTracker::Summary> LatencyTracker::summarize() const {
+    std::vector<Summary> result;
+    std::vector<float> sorted;
+    for (int type = 0; type < TYPE_COUNT; type++) {
+        const Samples& s = samples[type];
+        if (s.ms.empty()) continue;
+        sorted = s.ms;
+        std::sort(sorted.begin(), sorted.end());
+        // Nearest rank
+        auto at = [&sorted](double p) {
+            size_t rank = static_cast<size_t>(p * sorted.size() + 0.999999);
+            return static_cast<double>(sorted[std::min(std::max<size_t>(rank, 1), sorted.size()) - 1]);
+        };
+
+        Summary summary;
+        summary.type = typeName(type);
+        summary.count = s.count;
+        summary.p50Ms = at(0.50);
+        summary.p95Ms = at(0.95);
+        summary.p99Ms = at(0.99);
+        summary.maxMs = sorted.back();
+        result.push_back(summary);
+    }
+    return result;
+}
+
+void LatencyTracker::printSummary() const {
+    std::vector<Summary> rows = summarize();
+    if (rows.empty()) return;
+    std::printf("%-12s %8s %9s %9s %9s %9s   (input-to-present)\n", "event", "count", "p50 ms", "p95 ms", "p99 ms", "max ms");
+    for (const Summary& row : rows) {
+        std::printf("%-12s %8llu %9.3f %9.3f %9.3f %9.3f\n", row.type.c_str(),
+                    static_cast<unsigned long long>(row.count), row.p50Ms, row.p95Ms, row.p99Ms, row.maxMs);
+    }
+    std::fflush(stdout);
+}
+
+void LatencyTracker::reset() {
+    for (Samples& s : samples) {
+        s = Samples{};
+    }
+    pending.clear();
+}
@@ -0,0 +1,58 @@
+#ifndef LATENCYTRACKER_HPP
+#define LATENCYTRACKER_HPP
+
+#include <SDL3/SDL.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Input-to-present latency per event type.
+//
+// EventHandler reports each input event it handles with the event's SDL
+// timestamp (event.common.timestamp, same clock as SDL_GetTicksNS). The
+// events stay pending until the next SDL_RenderPresent, which is the first
+// frame that can show their effect; the time from the event to that present
+// is one sample. The last WINDOW samples per type are kept for percentiles.
+class LatencyTracker {
+public:
+    struct Summary {
+        std::string type;          // e.g. "keydown", "mousemotion"
+        uint64_t count = 0;        // Samples since start/reset
+        double p50Ms = 0.0;        // Over the last WINDOW samples
+        double p95Ms = 0.0;
+        double p99Ms = 0.0;
+        double maxMs = 0.0;
+    };
+
+    static const size_t WINDOW = 2048;
+
+private:
+    enum Type { KeyDown, KeyUp, TextInput, MouseDown, MouseUp, MouseMotion, Wheel,
+                TouchDown, TouchUp, TouchMotion, TYPE_COUNT };
+
+    struct Samples {
+        std::vector<float> ms;     // Ring of WINDOW samples
+        size_t next = 0;
+        uint64_t count = 0;
+    };
+
+    Samples samples[TYPE_COUNT];
+    std::vector<std::pair<Type, Uint64>> pending;   // Handled, not yet presented
+
+    static int typeOf(Uint32 eventType);
+    static const char* typeName(int type);
+
+public:
+    // An event was handled this frame (untracked types are ignored)
+    void eventHandled(Uint32 eventType, Uint64 timestampNs);
+
+    // Right after SDL_RenderPresent: turns pending events into samples
+    void presented(Uint64 presentNs);
+
+    // Types with at least one sample
+    std::vector<Summary> summarize() const;
+    void printSummary() const;
+    void reset();
+};
+
+#endif // LATENCYTRACKER_HPP
@@ -0,0 +1,275 @@
+#include "Log.hpp"
+#include "Trace.hpp"
+#include <SDL3/SDL.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace logging {
+
+std::atomic<int> minLevel{static_cast<int>(Level::Info)};
+
+namespace {
+
+// Bounded multi-producer queue (Vyukov): a slot is free for the producer
+// whose position equals its sequence, and readable once the producer has
+// bumped the sequence to position + 1
+struct Slot {
+    std::atomic<size_t> sequence{0};
+    Level level = Level::Info;
+    size_t length = 0;
+    char text[MAX_MESSAGE];
+};
+
+const size_t CAPACITY = 1024;           // Power of two (~1 MB of slots)
+Slot ring[CAPACITY];
+std::atomic<size_t> enqueuePos{0};
+size_t dequeuePos = 0;                  // Writer thread only
+
+std::atomic<bool> active{false};        // Writer thread running
+std::atomic<uint64_t> dropped{0};
+std::atomic<uint64_t> written{0};
+std::atomic<uint64_t> collapsed{0};
+
+std::thread writer;
+std::mutex wakeMutex;
+std::condition_variable wake;           // Writer: flush or stop requested
+std::condition_variable drained;        // flush(): writer caught up
+std::atomic<size_t> drainedPos{0};
+bool stopRequested = false;
+
+std::mutex syncMutex;                   // Synchronous writes (writer not running)
+
+// Writer state for the rate limiter
+struct Repeat {
+    uint64_t windowStart = 0;
+    uint64_t suppressed = 0;
+};
+std::unordered_map<std::string, Repeat> repeats;   // Key: level digit + text
+uint64_t reportedDrops = 0;
+
+const char* prefix(Level level) {
+    switch (level) {
+        case Level::Debug: return "[debug] ";
+        case Level::Warn: return "[warn] ";
+        case Level::Error: return "[error] ";
+        default: return "";
+    }
+}
+
+void appendLine(std::string& out, Level level, std::string_view text, uint64_t repeated = 0) {
+    out += prefix(level);
+    out += text;
+    if (repeated > 0) {
+        out += " (repeated ";
+        out += std::to_string(repeated);
+        out += " times)";
+    }
+    out += '\n';
+}
+
+void emit(const std::string& out, const std::string& err) {
+    if (!out.empty()) {
+        std::fwrite(out.data(), 1, out.size(), stdout);
+        std::fflush(stdout);
+    }
+    if (!err.empty()) {
+        std::fwrite(err.data(), 1, err.size(), stderr);
+        std::fflush(stderr);
+    }
+}
+
+bool pop(Level& level, std::string& text) {
+    Slot& slot = ring[dequeuePos & (CAPACITY - 1)];
+    size_t sequence = slot.sequence.load(std::memory_order_acquire);
+    if (sequence != dequeuePos + 1) return false;  // Empty, or still being written
+    level = slot.level;
+    text.assign(slot.text, slot.length);
+    slot.sequence.store(dequeuePos + CAPACITY, std::memory_order_release);
+    dequeuePos++;
+    return true;
+}
+
+// Move queued messages into the output buffers through the rate limiter
+void drain(std::string& out, std::string& err, uint64_t nowMs) {
+    Level level;
+    std::string text;
+    while (pop(level, text)) {
+        std::string key = std::to_string(static_cast<int>(level)) + text;
+        auto it = repeats.find(key);
+        if (it != repeats.end() && nowMs - it->second.windowStart < REPEAT_WINDOW_MS) {
+            it->second.suppressed++;
+            collapsed.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        if (it != repeats.end() && it->second.suppressed > 0) {
+            appendLine(level >= Level::Warn ? err : out, level, text, it->second.suppressed);
+        }
+        appendLine(level >= Level::Warn ? err : out, level, text);
+        repeats[key] = Repeat{nowMs, 0};
+        written.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    uint64_t drops = dropped.load(std::memory_order_relaxed);
+    if (drops != reportedDrops) {
+        appendLine(err, Level::Warn, "log buffer full: " + std::to_string(drops - reportedDrops) + " messages dropped");
+        reportedDrops = drops;
+    }
+}
+
+// Report collapsed repeats whose window has closed (all of them when stopping)
+void sweepRepeats(std::string& out, std::string& err, uint64_t nowMs, bool all) {
+    for (auto it = repeats.begin(); it != repeats.end();) {
+        if (!all && nowMs - it->second.windowStart < REPEAT_WINDOW_MS) {
+            ++it;
+            continue;
+        }
+        if (it->second.suppressed > 0) {
+            Level level = static_cast<Level>(it->first[0] - '0');
+            appendLine(level >= Level::Warn ? err : out, level,
+                       std::string_view(it->first).substr(1), it->second.suppressed);
+        }
+        it = repeats.erase(it);
+    }
+}
+
+void writerLoop() {
+    trace::setThreadName("Logger");
+    std::string out, err;
+    for (;;) {
+        bool stopping;
+        {
+            std::lock_guard<std::mutex> lock(wakeMutex);
+            stopping = stopRequested;
+        }
+
+        uint64_t nowMs = SDL_GetTicks();
+        drain(out, err, nowMs);
+        sweepRepeats(out, err, nowMs, stopping);
+        emit(out, err);
+        out.clear();
+        err.clear();
+
+        {
+            std::unique_lock<std::mutex> lock(wakeMutex);
+            drainedPos.store(dequeuePos, std::memory_order_release);
+            drained.notify_all();
+            if (stopping && dequeuePos == enqueuePos.load(std::memory_order_acquire)) break;
+            // Producers only signal every half ring (a wakeup per line would
+            // cost a syscall each); otherwise the writer polls
+            wake.wait_for(lock, std::chrono::milliseconds(5));
+        }
+    }
+}
+
+} // namespace
+
+void setLevel(Level level) {
+    minLevel.store(static_cast<int>(level), std::memory_order_relaxed);
+}
+
+Level getLevel() {
+    return static_cast<Level>(minLevel.load(std::memory_order_relaxed));
+}
+
+bool parseLevel(std::string_view name, Level& level) {
+    if (name == "debug") level = Level::Debug;
+    else if (name == "info") level = Level::Info;
+    else if (name == "warn") level = Level::Warn;
+    else if (name == "error") level = Level::Error;
+    else return false;
+    return true;
+}
+
+void write(Level level, std::string_view message) {
+    if (!enabled(level)) return;
+    size_t length = std::min(message.size(), MAX_MESSAGE);
+
+    if (!active.load(std::memory_order_acquire)) {
+        std::string line;
+        appendLine(line, level, message.substr(0, length));
+        std::lock_guard<std::mutex> lock(syncMutex);
+        std::fputs(line.c_str(), level >= Level::Warn ? stderr : stdout);
+        std::fflush(level >= Level::Warn ? stderr : stdout);
+        written.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    size_t pos = enqueuePos.load(std::memory_order_relaxed);
+    Slot* slot;
+    for (;;) {
+        slot = &ring[pos & (CAPACITY - 1)];
+        size_t sequence = slot->sequence.load(std::memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+        if (diff == 0) {
+            if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+        } else if (diff < 0) {
+            dropped.fetch_add(1, std::memory_order_relaxed);  // Full: never block the caller
+            return;
+        } else {
+            pos = enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+
+    slot->level = level;
+    slot->length = length;
+    std::memcpy(slot->text, message.data(), length);
+    slot->sequence.store(pos + 1, std::memory_order_release);
+
+    // Bursts: wake the writer every half ring instead of waiting for its poll
+    if ((pos & (CAPACITY / 2 - 1)) == 0) {
+        wake.notify_one();
+    }
+}
+
+void start() {
+    if (active.load()) return;
+    for (size_t i = 0; i < CAPACITY; i++) {
+        ring[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    enqueuePos.store(0);
+    dequeuePos = 0;
+    drainedPos.store(0);
+    stopRequested = false;
+    active.store(true, std::memory_order_release);
+    writer = std::thread(writerLoop);
+}
+
+void stop() {
+    if (!active.load()) return;
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        stopRequested = true;
+    }
+    wake.notify_one();
+    writer.join();
+    active.store(false, std::memory_order_release);
+}
+
+void flush() {
+    if (!active.load(std::memory_order_acquire)) {
+        std::fflush(stdout);
+        std::fflush(stderr);
+        return;
+    }
+    size_t target = enqueuePos.load(std::memory_order_acquire);
+    std::unique_lock<std::mutex> lock(wakeMutex);
+    wake.notify_one();
+    drained.wait(lock, [target] { return drainedPos.load(std::memory_order_acquire) >= target; });
+}
+
+Stats getStats() {
+    Stats stats;
+    stats.written = written.load(std::memory_order_relaxed);
+    stats.dropped = dropped.load(std::memory_order_relaxed);
+    stats.collapsed = collapsed.load(std::memory_order_relaxed);
+    return stats;
+}
+
+} // namespace logging
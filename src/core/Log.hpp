@@ -0,0 +1,79 @@
+#ifndef LOG_HPP
+#define LOG_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+// Asynchronous logging: callers format a line and push it into a lock-free
+// ring buffer; a background thread writes batches to stdout (debug, info) or
+// stderr (warn, error) and flushes once per batch.
+//
+//     logging::error("Lua update error: ", e.what());
+//
+// Logging never blocks the caller: when the ring is full the message is
+// dropped and counted. Identical messages (same level and text) are rate
+// limited: after the first, repeats within REPEAT_WINDOW_MS are collapsed
+// into one "(repeated N times)" line. Before start() and after stop() lines
+// are written synchronously.
+namespace logging {
+
+enum class Level { Debug, Info, Warn, Error };
+
+const size_t MAX_MESSAGE = 1000;        // Longer messages are truncated
+const uint64_t REPEAT_WINDOW_MS = 1000;
+
+extern std::atomic<int> minLevel;
+
+inline bool enabled(Level level) {
+    return static_cast<int>(level) >= minLevel.load(std::memory_order_relaxed);
+}
+
+void setLevel(Level level);
+Level getLevel();
+
+// "debug", "info", "warn" or "error"; returns false for anything else
+bool parseLevel(std::string_view name, Level& level);
+
+void write(Level level, std::string_view message);
+
+// Start/stop the writer thread (stop drains the buffer first)
+void start();
+void stop();
+
+// Block until everything logged so far has been written
+void flush();
+
+struct Stats {
+    uint64_t written = 0;
+    uint64_t dropped = 0;      // Ring buffer full
+    uint64_t collapsed = 0;    // Repeats folded by the rate limiter
+};
+Stats getStats();
+
+// Starts the writer for its lifetime (declare before anything that logs at exit)
+struct Session {
+    Session() { start(); }
+    ~Session() { stop(); }
+    Session(const Session&) = delete;
+    Session& operator=(const Session&) = delete;
+};
+
+template <typename... Args>
+void log(Level level, const Args&... args) {
+    if (!enabled(level)) return;
+    std::ostringstream line;
+    (line << ... << args);
+    write(level, line.str());
+}
+
+template <typename... Args> void debug(const Args&... args) { log(Level::Debug, args...); }
+template <typename... Args> void info(const Args&... args) { log(Level::Info, args...); }
+template <typename... Args> void warn(const Args&... args) { log(Level::Warn, args...); }
+template <typename... Args> void error(const Args&... args) { log(Level::Error, args...); }
+
+} // namespace logging
+
+#endif // LOG_HPP
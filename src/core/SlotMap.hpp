@@ -0,0 +1,130 @@
+#ifndef SLOTMAP_HPP
+#define SLOTMAP_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Handle into a SlotMap: slot index plus the generation it was issued for.
+// Generation 0 is never issued, so a default-constructed handle is always invalid.
+struct SlotHandle {
+    uint32_t index = 0;
+    uint32_t generation = 0;
+
+    bool operator==(const SlotHandle& other) const {
+        return index == other.index && generation == other.generation;
+    }
+    bool operator!=(const SlotHandle& other) const { return !(*this == other); }
+};
+
+// Generational slot map
+// Values are kept densely packed in a single vector (iteration is a contiguous
+// array walk), slots map stable handles to dense positions in O(1), and a
+// per-slot generation counter makes handles to erased values detectably stale.
+template <typename T>
+class SlotMap {
+private:
+    static constexpr uint32_t NO_SLOT = 0xFFFFFFFFu;
+
+    struct Slot {
+        uint32_t denseIndex = 0;      // Position in values while alive, next free slot while free
+        uint32_t generation = 1;
+        bool alive = false;
+    };
+
+    std::vector<T> values;            // Dense storage
+    std::vector<uint32_t> valueSlots; // values[i] belongs to slots[valueSlots[i]]
+    std::vector<Slot> slots;
+    uint32_t freeHead = NO_SLOT;
+
+public:
+    using iterator = typename std::vector<T>::iterator;
+    using const_iterator = typename std::vector<T>::const_iterator;
+
+    // Construct a value in place and return its handle
+    template <typename... Args>
+    SlotHandle emplace(Args&&... args) {
+        uint32_t slotIndex;
+        if (freeHead != NO_SLOT) {
+            slotIndex = freeHead;
+            freeHead = slots[slotIndex].denseIndex;
+        } else {
+            slotIndex = static_cast<uint32_t>(slots.size());
+            slots.emplace_back();
+        }
+
+        Slot& slot = slots[slotIndex];
+        slot.denseIndex = static_cast<uint32_t>(values.size());
+        slot.alive = true;
+        values.emplace_back(std::forward<Args>(args)...);
+        valueSlots.push_back(slotIndex);
+        return SlotHandle{slotIndex, slot.generation};
+    }
+
+    // Remove the value behind a handle; returns false if the handle was stale
+    bool erase(SlotHandle handle) {
+        if (!contains(handle)) return false;
+
+        Slot& slot = slots[handle.index];
+        uint32_t denseIndex = slot.denseIndex;
+        uint32_t lastIndex = static_cast<uint32_t>(values.size() - 1);
+
+        // Swap-remove keeps the value array dense
+        if (denseIndex != lastIndex) {
+            values[denseIndex] = std::move(values[lastIndex]);
+            valueSlots[denseIndex] = valueSlots[lastIndex];
+            slots[valueSlots[denseIndex]].denseIndex = denseIndex;
+        }
+        values.pop_back();
+        valueSlots.pop_back();
+
+        // Retire the slot: bump generation (skipping 0) and push it on the free list
+        slot.alive = false;
+        if (++slot.generation == 0) slot.generation = 1;
+        slot.denseIndex = freeHead;
+        freeHead = handle.index;
+        return true;
+    }
+
+    bool contains(SlotHandle handle) const {
+        return handle.index < slots.size()
+            && slots[handle.index].alive
+            && slots[handle.index].generation == handle.generation;
+    }
+
+    // O(1) lookup; returns nullptr for stale handles
+    T* get(SlotHandle handle) {
+        return contains(handle) ? &values[slots[handle.index].denseIndex] : nullptr;
+    }
+
+    const T* get(SlotHandle handle) const {
+        return contains(handle) ? &values[slots[handle.index].denseIndex] : nullptr;
+    }
+
+    // Handle of the value stored at a dense position (valid for 0 <= i < size())
+    SlotHandle handleAt(size_t denseIndex) const {
+        uint32_t slotIndex = valueSlots[denseIndex];
+        return SlotHandle{slotIndex, slots[slotIndex].generation};
+    }
+
+    // Remove every value; outstanding handles all become stale
+    void clear() {
+        while (!values.empty()) {
+            erase(handleAt(values.size() - 1));
+        }
+    }
+
+    size_t size() const { return values.size(); }
+    bool empty() const { return values.empty(); }
+
+    T& operator[](size_t denseIndex) { return values[denseIndex]; }
+    const T& operator[](size_t denseIndex) const { return values[denseIndex]; }
+
+    iterator begin() { return values.begin(); }
+    iterator end() { return values.end(); }
+    const_iterator begin() const { return values.begin(); }
+    const_iterator end() const { return values.end(); }
+};
+
+#endif // SLOTMAP_HPP
@@ -0,0 +1,171 @@
+#include "Trace.hpp"
+#include "Log.hpp"
+#include <SDL3/SDL.h>
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace trace {
+
+std::atomic<bool> recording{false};
+
+namespace {
+
+struct Event {
+    const char* name;
+    uint64_t start;
+    uint64_t end;
+};
+
+// One per thread that ever recorded; kept until exit so events of finished
+// threads (asset loaders) still get written
+struct ThreadBuffer {
+    std::mutex mutex;                // Only contended while writing the file
+    std::vector<Event> events;
+    uint64_t dropped = 0;
+    uint32_t id = 0;
+    std::string name;
+    std::vector<std::pair<const char*, uint64_t>> open;   // traceBegin stack
+};
+
+const size_t MAX_EVENTS_PER_THREAD = 1 << 20;
+
+std::mutex registryMutex;
+std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+std::unordered_set<std::string> internedNames;
+std::atomic<uint64_t> epoch{0};
+
+ThreadBuffer& localBuffer() {
+    thread_local ThreadBuffer* buffer = nullptr;
+    if (!buffer) {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        buffers.push_back(std::make_unique<ThreadBuffer>());
+        buffer = buffers.back().get();
+        buffer->id = static_cast<uint32_t>(buffers.size());
+    }
+    return *buffer;
+}
+
+void writeEscaped(SDL_IOStream* io, const char* text) {
+    for (const char* p = text; *p; p++) {
+        unsigned char c = static_cast<unsigned char>(*p);
+        if (c == '"' || c == '\\') {
+            SDL_IOprintf(io, "\\%c", c);
+        } else if (c < 0x20) {
+            SDL_IOprintf(io, "\\u%04x", c);
+        } else {
+            SDL_WriteU8(io, c);
+        }
+    }
+}
+
+} // namespace
+
+uint64_t now() {
+    return SDL_GetTicksNS();
+}
+
+void record(const char* name, uint64_t startNs, uint64_t endNs) {
+    // Spans opened before the current recording started are cut at its
+    // start; ones that ended before it are left out
+    uint64_t from = epoch.load(std::memory_order_relaxed);
+    if (endNs < from) return;
+    startNs = std::max(startNs, from);
+
+    ThreadBuffer& buffer = localBuffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    if (buffer.events.size() >= MAX_EVENTS_PER_THREAD) {
+        buffer.dropped++;
+        return;
+    }
+    buffer.events.push_back(Event{name, startNs, endNs});
+}
+
+void start() {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    for (auto& buffer : buffers) {
+        std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+        buffer->events.clear();
+        buffer->dropped = 0;
+    }
+    epoch.store(now(), std::memory_order_relaxed);
+    recording.store(true, std::memory_order_relaxed);
+}
+
+void stop() {
+    recording.store(false, std::memory_order_relaxed);
+}
+
+void setThreadName(const char* name) {
+    ThreadBuffer& buffer = localBuffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    buffer.name = name;
+}
+
+void begin(const std::string& name) {
+    if (!isRecording()) return;
+    const char* interned;
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        interned = internedNames.insert(name).first->c_str();
+    }
+    localBuffer().open.emplace_back(interned, now());
+}
+
+void end() {
+    ThreadBuffer& buffer = localBuffer();
+    if (buffer.open.empty()) return;
+    auto [name, start] = buffer.open.back();
+    buffer.open.pop_back();
+    if (isRecording()) {
+        record(name, start, now());
+    }
+}
+
+bool write(const std::string& path) {
+    SDL_IOStream* io = SDL_IOFromFile(path.c_str(), "w");
+    if (!io) {
+        logging::error("Failed to write trace ", path, ": ", SDL_GetError());
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(registryMutex);
+    size_t written = 0;
+    uint64_t dropped = 0;
+    bool first = true;
+    SDL_IOprintf(io, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    for (auto& buffer : buffers) {
+        std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+        if (!buffer->name.empty()) {
+            SDL_IOprintf(io, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"",
+                         first ? "" : ",\n", buffer->id);
+            writeEscaped(io, buffer->name.c_str());
+            SDL_IOprintf(io, "\"}}");
+            first = false;
+        }
+        for (const Event& event : buffer->events) {
+            SDL_IOprintf(io, "%s{\"name\":\"", first ? "" : ",\n");
+            writeEscaped(io, event.name);
+            SDL_IOprintf(io, "\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                         buffer->id, (event.start - epoch.load(std::memory_order_relaxed)) / 1000.0, (event.end - event.start) / 1000.0);
+            first = false;
+        }
+        written += buffer->events.size();
+        dropped += buffer->dropped;
+    }
+    SDL_IOprintf(io, "\n]}\n");
+    SDL_CloseIO(io);
+
+    if (dropped > 0) {
+        logging::info("Wrote ", written, " trace events to ", path,
+                      " (", dropped, " dropped, buffer full)");
+    } else {
+        logging::info("Wrote ", written, " trace events to ", path);
+    }
+    return true;
+}
+
+} // namespace trace
@@ -0,0 +1,68 @@
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Scoped-zone timeline tracing, written as Chrome trace-event JSON (loads in
+// chrome://tracing and ui.perfetto.dev).
+//
+//     void FontManager::load() {
+//         TRACE_ZONE("FontManager::load");
+//         ...
+//     }
+//
+// Zones are recorded into a per-thread buffer while a recording is active.
+// When it is not, a zone costs one relaxed atomic load and a branch. Names
+// must be string literals (or otherwise outlive the recording); Lua zone
+// names are interned.
+namespace trace {
+
+extern std::atomic<bool> recording;
+
+inline bool isRecording() {
+    return recording.load(std::memory_order_relaxed);
+}
+
+uint64_t now();
+void record(const char* name, uint64_t startNs, uint64_t endNs);
+
+class Zone {
+    const char* name;
+    uint64_t start;
+    bool active;
+
+public:
+    explicit Zone(const char* zoneName) : name(zoneName), start(0), active(isRecording()) {
+        if (active) start = now();
+    }
+    ~Zone() {
+        if (active) record(name, start, now());
+    }
+
+    Zone(const Zone&) = delete;
+    Zone& operator=(const Zone&) = delete;
+};
+
+// Start recording (drops events of an earlier recording)
+void start();
+void stop();
+
+// Name the calling thread in the trace
+void setThreadName(const char* name);
+
+// Unscoped zones for Lua (traceBegin/traceEnd), nested per thread
+void begin(const std::string& name);
+void end();
+
+// Write everything recorded so far as trace-event JSON
+bool write(const std::string& path);
+
+} // namespace trace
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_ZONE(name) trace::Zone TRACE_CONCAT(traceZone, __LINE__)(name)
+
+#endif // TRACE_HPP
@@ -1,15 +1,23 @@
 #include "EventHandler.hpp"
+#include "InputRecorder.hpp"
 #include "../widgets/TextWidget.hpp"
-#include <iostream>
+#include "../layout/LayoutNode.hpp"
+#include "../core/Trace.hpp"
+#include "../core/FrameStats.hpp"
+#include "../core/LatencyTracker.hpp"
+#include "../core/Log.hpp"
+#include "../lua/ScriptWatchdog.hpp"
 
 EventHandler::EventHandler(sol::state& luaState,
-                           std::map<int, std::shared_ptr<TextWidget>>& widgets,
+                           SlotMap<TextWidget>& widgets,
+                           std::shared_ptr<LayoutNode>& layoutRoot,
                            SDL_Window* win,
                            bool& runningFlag,
                            int& winWidth,
                            int& winHeight)
     : lua(luaState)
     , textWidgets(widgets)
+    , rootLayout(layoutRoot)
     , window(win)
     , running(runningFlag)
     , windowWidth(winWidth)
@@ -18,68 +26,100 @@ EventHandler::EventHandler(sol::state& luaState,
 }
 
 void EventHandler::handleEvents() {
+    TRACE_ZONE("EventHandler::handleEvents");
     SDL_Event event;
     while (SDL_PollEvent(&event)) {
-        switch (event.type) {
-            case SDL_EVENT_QUIT:
-                handleQuit();
-                break;
-            case SDL_EVENT_WINDOW_RESIZED:
-                handleWindowResize(event);
-                break;
-            case SDL_EVENT_KEY_DOWN:
-                handleKeyDown(event);
-                break;
-            case SDL_EVENT_KEY_UP:
-                handleKeyUp(event);
-                break;
-            case SDL_EVENT_MOUSE_BUTTON_DOWN:
-                handleMouseButtonDown(event);
-                break;
-            case SDL_EVENT_MOUSE_BUTTON_UP:
-                handleMouseButtonUp(event);
-                break;
-            case SDL_EVENT_MOUSE_MOTION:
-                handleMouseMotion(event);
-                break;
-            case SDL_EVENT_MOUSE_WHEEL:
-                handleMouseWheel(event);
-                break;
-            case SDL_EVENT_TEXT_INPUT:
-                handleTextInput(event);
-                break;
-            case SDL_EVENT_FINGER_DOWN:
-                handleFingerDown(event);
-                break;
-            case SDL_EVENT_FINGER_UP:
-                handleFingerUp(event);
-                break;
-            case SDL_EVENT_FINGER_MOTION:
-                handleFingerMotion(event);
-                break;
+        if (inputRecorder && !inputRecorder->process(event)) continue;
+        frameCounters::events++;
+        if (scriptWatchdog) {
+            ScriptWatchdog::Scope budget(*scriptWatchdog, ScriptWatchdog::Event);
+            dispatch(event);
+        } else {
+            dispatch(event);
         }
+
+        // Widgets and Lua callbacks have applied the event; the next present shows it
+        if (latencyTracker) latencyTracker->eventHandled(event.type, event.common.timestamp);
+    }
+}
+
+void EventHandler::dispatch(const SDL_Event& event) {
+    switch (event.type) {
+        case SDL_EVENT_QUIT:
+            handleQuit();
+            break;
+        case SDL_EVENT_WINDOW_RESIZED:
+            handleWindowResize(event);
+            break;
+        case SDL_EVENT_KEY_DOWN:
+            handleKeyDown(event);
+            break;
+        case SDL_EVENT_KEY_UP:
+            handleKeyUp(event);
+            break;
+        case SDL_EVENT_MOUSE_BUTTON_DOWN:
+            handleMouseButtonDown(event);
+            break;
+        case SDL_EVENT_MOUSE_BUTTON_UP:
+            handleMouseButtonUp(event);
+            break;
+        case SDL_EVENT_MOUSE_MOTION:
+            handleMouseMotion(event);
+            break;
+        case SDL_EVENT_MOUSE_WHEEL:
+            handleMouseWheel(event);
+            break;
+        case SDL_EVENT_TEXT_INPUT:
+            handleTextInput(event);
+            break;
+        case SDL_EVENT_FINGER_DOWN:
+            handleFingerDown(event);
+            break;
+        case SDL_EVENT_FINGER_UP:
+            handleFingerUp(event);
+            break;
+        case SDL_EVENT_FINGER_MOTION:
+            handleFingerMotion(event);
+            break;
+        case SDL_EVENT_RENDER_TARGETS_RESET:
+        case SDL_EVENT_RENDER_DEVICE_RESET:
+            if (onRenderReset) onRenderReset();
+            break;
     }
 }
 
 void EventHandler::handleQuit() {
+    TRACE_ZONE("EventHandler::handleQuit");
     running = false;
 }
 
 void EventHandler::handleWindowResize(const SDL_Event& event) {
+    TRACE_ZONE("EventHandler::handleWindowResize");
     windowWidth = event.window.data1;
     windowHeight = event.window.data2;
+
+    // Only the root needs invalidating: children whose rectangles come out
+    // unchanged keep their cached layout
+    if (rootLayout) {
+        rootLayout->markDirty();
+    }
 }
 
 void EventHandler::handleKeyDown(const SDL_Event& event) {
+    TRACE_ZONE("EventHandler::handleKeyDown");
     // Route to widgets first
+    if (onDebugKey && onDebugKey(event.key.key)) return;
+
+    // Modifiers as of the event (also correct for replayed events)
     std::string keyName = SDL_GetKeyName(event.key.key);
-    SDL_Keymod mod = SDL_GetModState();
+    SDL_Keymod mod = event.key.mod;
     bool shift = (mod & SDL_KMOD_SHIFT) != 0;
     bool ctrl = (mod & SDL_KMOD_CTRL) != 0;
     bool consumed = false;
 
-    for (auto& [id, widget] : textWidgets) {
-        if (widget->handleKeyDown(keyName, shift, ctrl)) {
+    for (auto& widget : textWidgets) {
+        if (!widget.acceptsInput()) continue;
+        if (widget.handleKeyDown(keyName, shift, ctrl)) {
             consumed = true;
             break;
         }
@@ -92,36 +132,39 @@ void EventHandler::handleKeyDown(const SDL_Event& event) {
             try {
                 (*onKeyDown)(keyName);
             } catch (const sol::error& e) {
-                std::cerr << "Lua onKeyDown error: " << e.what() << std::endl;
+                logging::error("Lua onKeyDown error: ", e.what());
             }
         }
     }
 }
 
 void EventHandler::handleKeyUp(const SDL_Event& event) {
+    TRACE_ZONE("EventHandler::handleKeyUp");
     // Call Lua onKeyUp if it exists
     sol::optional<sol::function> onKeyUp = lua["onKeyUp"];
     if (onKeyUp) {
         try {
             (*onKeyUp)(SDL_GetKeyName(event.key.key));
         } catch (const sol::error& e) {
-            std::cerr << "Lua onKeyUp error: " << e.what() << std::endl;
+            logging::error("Lua onKeyUp error: ", e.what());
         }
     }
 }
 
 void EventHandler::handleMouseButtonDown(const SDL_Event& event) {
+    TRACE_ZONE("EventHandler::handleMouseButtonDown");
     // First, unfocus all widgets so only the clicked one will have focus
-    for (auto& [id, widget] : textWidgets) {
-        if (widget->hasFocus() && !widget->hitTest(event.button.x, event.button.y)) {
-            widget->setFocus(false);
+    for (auto& widget : textWidgets) {
+        if (widget.hasFocus() && !widget.hitTest(event.button.x, event.button.y)) {
+            widget.setFocus(false);
         }
     }
 
     // Now handle the click
     bool consumed = false;
-    for (auto& [id, widget] : textWidgets) {
-        if (widget->handleMouseDown(event.button.x, event.button.y, event.button.button)) {
+    for (auto& widget : textWidgets) {
+        if (!widget.acceptsInput()) continue;
+        if (widget.handleMouseDown(event.button.x, event.button.y, event.button.button)) {
             consumed = true;
             break;
         }
@@ -134,16 +177,18 @@ void EventHandler::handleMouseButtonDown(const SDL_Event& event) {
             try {
                 (*onMouseDown)(event.button.x, event.button.y, event.button.button);
             } catch (const sol::error& e) {
-                std::cerr << "Lua onMouseDown error: " << e.what() << std::endl;
+                logging::error("Lua onMouseDown error: ", e.what());
             }
         }
     }
 }
 
 void EventHandler::handleMouseButtonUp(const SDL_Event& event) {
+    TRACE_ZONE("EventHandler::handleMouseButtonUp");
     // Route to widgets first
-    for (auto& [id, widget] : textWidgets) {
-        widget->handleMouseUp(event.button.x, event.button.y, event.button.button);
+    for (auto& widget : textWidgets) {
+        if (!widget.acceptsInput()) continue;
+        widget.handleMouseUp(event.button.x, event.button.y, event.button.button);
     }
 
     // Always call Lua onMouseUp
@@ -152,15 +197,17 @@ void EventHandler::handleMouseButtonUp(const SDL_Event& event) {
         try {
             (*onMouseUp)(event.button.x, event.button.y, event.button.button);
         } catch (const sol::error& e) {
-            std::cerr << "Lua onMouseUp error: " << e.what() << std::endl;
+            logging::error("Lua onMouseUp error: ", e.what());
         }
     }
 }
 
 void EventHandler::handleMouseMotion(const SDL_Event& event) {
+    TRACE_ZONE("EventHandler::handleMouseMotion");
     // Route to widgets first (for drag selection)
-    for (auto& [id, widget] : textWidgets) {
-        widget->handleMouseMove(event.motion.x, event.motion.y);
+    for (auto& widget : textWidgets) {
+        if (!widget.acceptsInput()) continue;
+        widget.handleMouseMove(event.motion.x, event.motion.y);
     }
 
     // Always call Lua onMouseMove
@@ -169,30 +216,31 @@ void EventHandler::handleMouseMotion(const SDL_Event& event) {
         try {
             (*onMouseMove)(event.motion.x, event.motion.y);
         } catch (const sol::error& e) {
-            std::cerr << "Lua onMouseMove error: " << e.what() << std::endl;
+            logging::error("Lua onMouseMove error: ", e.what());
         }
     }
 }
 
 void EventHandler::handleMouseWheel(const SDL_Event& event) {
+    TRACE_ZONE("EventHandler::handleMouseWheel");
     // Call Lua onMouseWheel if it exists
     sol::optional<sol::function> onMouseWheel = lua["onMouseWheel"];
     if (onMouseWheel) {
         try {
-            float mouseX, mouseY;
-            SDL_GetMouseState(&mouseX, &mouseY);
-            (*onMouseWheel)(mouseX, mouseY, event.wheel.x, event.wheel.y);
+            (*onMouseWheel)(event.wheel.mouse_x, event.wheel.mouse_y, event.wheel.x, event.wheel.y);
         } catch (const sol::error& e) {
-            std::cerr << "Lua onMouseWheel error: " << e.what() << std::endl;
+            logging::error("Lua onMouseWheel error: ", e.what());
         }
     }
 }
 
 void EventHandler::handleTextInput(const SDL_Event& event) {
+    TRACE_ZONE("EventHandler::handleTextInput");
     // Route to widgets first
     bool consumed = false;
-    for (auto& [id, widget] : textWidgets) {
-        if (widget->handleTextInput(event.text.text)) {
+    for (auto& widget : textWidgets) {
+        if (!widget.acceptsInput()) continue;
+        if (widget.handleTextInput(event.text.text)) {
             consumed = true;
             break;
         }
@@ -205,13 +253,14 @@ void EventHandler::handleTextInput(const SDL_Event& event) {
             try {
                 (*onTextInput)(event.text.text);
             } catch (const sol::error& e) {
-                std::cerr << "Lua onTextInput error: " << e.what() << std::endl;
+                logging::error("Lua onTextInput error: ", e.what());
             }
         }
     }
 }
 
 void EventHandler::handleFingerDown(const SDL_Event& event) {
+    TRACE_ZONE("EventHandler::handleFingerDown");
     // Call Lua onTouchDown if it exists
     sol::optional<sol::function> onTouchDown = lua["onTouchDown"];
     if (onTouchDown) {
@@ -220,7 +269,7 @@ void EventHandler::handleFingerDown(const SDL_Event& event) {
             float y = event.tfinger.y * windowHeight;
             (*onTouchDown)(event.tfinger.fingerID, x, y, event.tfinger.pressure);
         } catch (const sol::error& e) {
-            std::cerr << "Lua onTouchDown error: " << e.what() << std::endl;
+            logging::error("Lua onTouchDown error: ", e.what());
         }
     }
 
@@ -232,12 +281,13 @@ void EventHandler::handleFingerDown(const SDL_Event& event) {
             float y = event.tfinger.y * windowHeight;
             (*onMouseDown)(x, y, 1); // Treat as left click
         } catch (const sol::error& e) {
-            std::cerr << "Lua onMouseDown error: " << e.what() << std::endl;
+            logging::error("Lua onMouseDown error: ", e.what());
         }
     }
 }
 
 void EventHandler::handleFingerUp(const SDL_Event& event) {
+    TRACE_ZONE("EventHandler::handleFingerUp");
     // Call Lua onTouchUp if it exists
     sol::optional<sol::function> onTouchUp = lua["onTouchUp"];
     if (onTouchUp) {
@@ -246,12 +296,13 @@ void EventHandler::handleFingerUp(const SDL_Event& event) {
             float y = event.tfinger.y * windowHeight;
             (*onTouchUp)(event.tfinger.fingerID, x, y);
         } catch (const sol::error& e) {
-            std::cerr << "Lua onTouchUp error: " << e.what() << std::endl;
+            logging::error("Lua onTouchUp error: ", e.what());
         }
     }
 }
 
 void EventHandler::handleFingerMotion(const SDL_Event& event) {
+    TRACE_ZONE("EventHandler::handleFingerMotion");
     // Call Lua onTouchMove if it exists
     sol::optional<sol::function> onTouchMove = lua["onTouchMove"];
     if (onTouchMove) {
@@ -262,7 +313,7 @@ void EventHandler::handleFingerMotion(const SDL_Event& event) {
             float dy = event.tfinger.dy * windowHeight;
             (*onTouchMove)(event.tfinger.fingerID, x, y, dx, dy);
         } catch (const sol::error& e) {
-            std::cerr << "Lua onTouchMove error: " << e.what() << std::endl;
+            logging::error("Lua onTouchMove error: ", e.what());
         }
     }
 }
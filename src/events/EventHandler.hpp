@@ -3,24 +3,37 @@
 
 #include <SDL3/SDL.h>
 #include <sol/sol.hpp>
-#include <map>
+#include <functional>
 #include <memory>
 
-// Forward declaration
+#include "../core/SlotMap.hpp"
+
+// Forward declarations
 class TextWidget;
+class LayoutNode;
+class InputRecorder;
+class LatencyTracker;
+class ScriptWatchdog;
 
 class EventHandler {
 private:
     sol::state& lua;
-    std::map<int, std::shared_ptr<TextWidget>>& textWidgets;
+    SlotMap<TextWidget>& textWidgets;
+    std::shared_ptr<LayoutNode>& rootLayout;
     SDL_Window* window;
     bool& running;
     int& windowWidth;
     int& windowHeight;
+    std::function<void()> onRenderReset;
+    std::function<bool(SDL_Keycode)> onDebugKey;
+    InputRecorder* inputRecorder = nullptr;
+    LatencyTracker* latencyTracker = nullptr;
+    ScriptWatchdog* scriptWatchdog = nullptr;
 
 public:
     EventHandler(sol::state& luaState,
-                 std::map<int, std::shared_ptr<TextWidget>>& widgets,
+                 SlotMap<TextWidget>& widgets,
+                 std::shared_ptr<LayoutNode>& layoutRoot,
                  SDL_Window* win,
                  bool& runningFlag,
                  int& winWidth,
@@ -29,7 +42,27 @@ public:
     // Process all SDL events
     void handleEvents();
 
+    // Called when render target textures were lost (device or target reset)
+    void setRenderResetCallback(std::function<void()> callback) { onRenderReset = std::move(callback); }
+
+    // Application hotkeys (e.g. F3 for the performance overlay), checked
+    // before widgets and Lua; returning true consumes the key
+    void setDebugKeyCallback(std::function<bool(SDL_Keycode)> callback) { onDebugKey = std::move(callback); }
+
+    // Every polled event passes through the recorder (record / replay)
+    void setInputRecorder(InputRecorder* recorder) { inputRecorder = recorder; }
+
+    // Handled events are reported with their SDL timestamp for
+    // input-to-present latency
+    void setLatencyTracker(LatencyTracker* tracker) { latencyTracker = tracker; }
+
+    // Each event's widget and Lua callbacks run under the "event" budget
+    void setScriptWatchdog(ScriptWatchdog* watchdog) { scriptWatchdog = watchdog; }
+
 private:
+    // Runs the handler for one event
+    void dispatch(const SDL_Event& event);
+
     // Helper methods for specific event types
     void handleQuit();
     void handleWindowResize(const SDL_Event& event);
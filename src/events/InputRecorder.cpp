@@ -0,0 +1,339 @@
+#include "InputRecorder.hpp"
+#include "../core/Log.hpp"
+#include <cstring>
+
+namespace {
+
+const char MAGIC[4] = {'I', 'R', 'E', 'C'};
+const uint8_t VERSION = 1;
+
+void putU8(std::vector<uint8_t>& out, uint8_t v) {
+    out.push_back(v);
+}
+
+void putFixed(std::vector<uint8_t>& out, uint64_t v, int bytes) {
+    for (int i = 0; i < bytes; i++) {
+        out.push_back(static_cast<uint8_t>(v >> (8 * i)));
+    }
+}
+
+void putVarint(std::vector<uint8_t>& out, uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back(static_cast<uint8_t>(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(v));
+}
+
+void putFloat(std::vector<uint8_t>& out, float f) {
+    uint32_t bits;
+    std::memcpy(&bits, &f, sizeof(bits));
+    putFixed(out, bits, 4);
+}
+
+// Bounds-checked reads; a failed read leaves `ok` false for the caller
+struct Reader {
+    const uint8_t*& data;
+    const uint8_t* end;
+    bool ok = true;
+
+    uint64_t fixed(int bytes) {
+        if (end - data < bytes) {
+            ok = false;
+            return 0;
+        }
+        uint64_t v = 0;
+        for (int i = 0; i < bytes; i++) {
+            v |= static_cast<uint64_t>(*data++) << (8 * i);
+        }
+        return v;
+    }
+
+    uint64_t varint() {
+        uint64_t v = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (data >= end) break;
+            uint8_t b = *data++;
+            v |= static_cast<uint64_t>(b & 0x7f) << shift;
+            if (!(b & 0x80)) return v;
+        }
+        ok = false;
+        return 0;
+    }
+
+    float real() {
+        uint32_t bits = static_cast<uint32_t>(fixed(4));
+        float f;
+        std::memcpy(&f, &bits, sizeof(f));
+        return f;
+    }
+};
+
+} // namespace
+
+bool InputRecorder::isRecorded(Uint32 type) {
+    // The event types EventHandler::handleEvents dispatches
+    switch (type) {
+        case SDL_EVENT_QUIT:
+        case SDL_EVENT_WINDOW_RESIZED:
+        case SDL_EVENT_KEY_DOWN:
+        case SDL_EVENT_KEY_UP:
+        case SDL_EVENT_MOUSE_BUTTON_DOWN:
+        case SDL_EVENT_MOUSE_BUTTON_UP:
+        case SDL_EVENT_MOUSE_MOTION:
+        case SDL_EVENT_MOUSE_WHEEL:
+        case SDL_EVENT_TEXT_INPUT:
+        case SDL_EVENT_FINGER_DOWN:
+        case SDL_EVENT_FINGER_UP:
+        case SDL_EVENT_FINGER_MOTION:
+            return true;
+        default:
+            return false;
+    }
+}
+
+void InputRecorder::startRecording() {
+    events.clear();
+    nextEvent = 0;
+    started = false;
+    mode = Mode::Recording;
+}
+
+bool InputRecorder::stopRecording(const std::string& path) {
+    if (mode != Mode::Recording) return false;
+    mode = Mode::Off;
+
+    std::vector<uint8_t> out(MAGIC, MAGIC + 4);
+    putU8(out, VERSION);
+    putVarint(out, events.size());
+    uint64_t previousFrame = 0;
+    for (const RecordedEvent& recorded : events) {
+        encode(out, recorded, previousFrame);
+        previousFrame = recorded.frame;
+    }
+
+    if (!SDL_SaveFile(path.c_str(), out.data(), out.size())) {
+        logging::error("Failed to write input recording ", path, ": ", SDL_GetError());
+        return false;
+    }
+    logging::info("Wrote ", events.size(), " input events over ", (frame + 1), " frames to ",
+                  path, " (", out.size(), " bytes)");
+    return true;
+}
+
+bool InputRecorder::loadReplay(const std::string& path) {
+    size_t size = 0;
+    uint8_t* file = static_cast<uint8_t*>(SDL_LoadFile(path.c_str(), &size));
+    if (!file) {
+        logging::error("Failed to read input recording ", path, ": ", SDL_GetError());
+        return false;
+    }
+
+    const uint8_t* data = file;
+    const uint8_t* end = file + size;
+    std::vector<RecordedEvent> loaded;
+    bool ok = size >= 5 && std::memcmp(data, MAGIC, 4) == 0 && data[4] == VERSION;
+    if (ok) {
+        data += 5;
+        Reader reader{data, end};
+        uint64_t count = reader.varint();
+        ok = reader.ok && count <= size;  // Every event takes at least a byte
+        uint64_t previousFrame = 0;
+        for (uint64_t i = 0; ok && i < count; i++) {
+            RecordedEvent recorded;
+            ok = decode(data, end, recorded, previousFrame);
+            previousFrame = recorded.frame;
+            loaded.push_back(std::move(recorded));
+        }
+    }
+    SDL_free(file);
+
+    if (!ok) {
+        logging::error("Invalid input recording ", path);
+        return false;
+    }
+
+    events = std::move(loaded);
+    // Text pointers are set once the vector no longer moves
+    for (RecordedEvent& recorded : events) {
+        if (recorded.event.type == SDL_EVENT_TEXT_INPUT) {
+            recorded.event.text.text = recorded.text.c_str();
+        }
+    }
+    nextEvent = 0;
+    started = false;
+    mode = Mode::Replaying;
+    logging::info("Replaying ", events.size(), " input events from ", path);
+    return true;
+}
+
+void InputRecorder::stopReplay() {
+    if (mode == Mode::Replaying) {
+        mode = Mode::Off;
+    }
+}
+
+void InputRecorder::beginFrame(uint64_t frameCounter) {
+    if (mode == Mode::Off) return;
+    if (!started) {
+        startFrame = frameCounter;
+        started = true;
+    }
+    frame = frameCounter - startFrame;
+    frameStartNs = SDL_GetTicksNS();
+
+    if (mode != Mode::Replaying) return;
+    for (; nextEvent < events.size() && events[nextEvent].frame <= frame; nextEvent++) {
+        SDL_Event event = events[nextEvent].event;
+        event.common.timestamp = frameStartNs;
+        event.common.reserved = REPLAY_MARK;
+        SDL_PushEvent(&event);
+    }
+}
+
+bool InputRecorder::process(const SDL_Event& event) {
+    if (mode == Mode::Replaying) {
+        // Live input would make the run diverge; closing the window still works
+        return !isRecorded(event.type) || event.type == SDL_EVENT_QUIT ||
+               event.common.reserved == REPLAY_MARK;
+    }
+    if (mode == Mode::Recording && started && isRecorded(event.type)) {
+        RecordedEvent recorded;
+        recorded.frame = frame;
+        Uint64 now = SDL_GetTicksNS();
+        recorded.offsetUs = static_cast<uint32_t>((now - frameStartNs) / SDL_NS_PER_US);
+        recorded.event = event;
+        if (event.type == SDL_EVENT_TEXT_INPUT && event.text.text) {
+            recorded.text = event.text.text;
+        }
+        events.push_back(std::move(recorded));
+    }
+    return true;
+}
+
+void InputRecorder::encode(std::vector<uint8_t>& out, const RecordedEvent& recorded, uint64_t previousFrame) {
+    const SDL_Event& e = recorded.event;
+    putVarint(out, recorded.frame - previousFrame);
+    putVarint(out, recorded.offsetUs);
+    putVarint(out, e.type);
+
+    switch (e.type) {
+        case SDL_EVENT_WINDOW_RESIZED:
+            putFixed(out, static_cast<uint32_t>(e.window.data1), 4);
+            putFixed(out, static_cast<uint32_t>(e.window.data2), 4);
+            break;
+        case SDL_EVENT_KEY_DOWN:
+        case SDL_EVENT_KEY_UP:
+            putFixed(out, e.key.key, 4);
+            putFixed(out, e.key.scancode, 2);
+            putFixed(out, e.key.mod, 2);
+            putU8(out, (e.key.down ? 1 : 0) | (e.key.repeat ? 2 : 0));
+            break;
+        case SDL_EVENT_MOUSE_BUTTON_DOWN:
+        case SDL_EVENT_MOUSE_BUTTON_UP:
+            putU8(out, e.button.button);
+            putU8(out, e.button.clicks);
+            putFloat(out, e.button.x);
+            putFloat(out, e.button.y);
+            break;
+        case SDL_EVENT_MOUSE_MOTION:
+            putFixed(out, e.motion.state, 4);
+            putFloat(out, e.motion.x);
+            putFloat(out, e.motion.y);
+            putFloat(out, e.motion.xrel);
+            putFloat(out, e.motion.yrel);
+            break;
+        case SDL_EVENT_MOUSE_WHEEL:
+            putFloat(out, e.wheel.x);
+            putFloat(out, e.wheel.y);
+            putFloat(out, e.wheel.mouse_x);
+            putFloat(out, e.wheel.mouse_y);
+            putU8(out, static_cast<uint8_t>(e.wheel.direction));
+            break;
+        case SDL_EVENT_TEXT_INPUT:
+            putVarint(out, recorded.text.size());
+            out.insert(out.end(), recorded.text.begin(), recorded.text.end());
+            break;
+        case SDL_EVENT_FINGER_DOWN:
+        case SDL_EVENT_FINGER_UP:
+        case SDL_EVENT_FINGER_MOTION:
+            putFixed(out, e.tfinger.fingerID, 8);
+            putFloat(out, e.tfinger.x);
+            putFloat(out, e.tfinger.y);
+            putFloat(out, e.tfinger.dx);
+            putFloat(out, e.tfinger.dy);
+            putFloat(out, e.tfinger.pressure);
+            break;
+        default:  // Quit: type only
+            break;
+    }
+}
+
+bool InputRecorder::decode(const uint8_t*& data, const uint8_t* end, RecordedEvent& recorded, uint64_t previousFrame) {
+    Reader in{data, end};
+    SDL_Event& e = recorded.event;
+    SDL_zero(e);
+    recorded.frame = previousFrame + in.varint();
+    recorded.offsetUs = static_cast<uint32_t>(in.varint());
+    e.type = static_cast<Uint32>(in.varint());
+    if (!in.ok || !isRecorded(e.type)) return false;
+
+    switch (e.type) {
+        case SDL_EVENT_WINDOW_RESIZED:
+            e.window.data1 = static_cast<Sint32>(in.fixed(4));
+            e.window.data2 = static_cast<Sint32>(in.fixed(4));
+            break;
+        case SDL_EVENT_KEY_DOWN:
+        case SDL_EVENT_KEY_UP: {
+            e.key.key = static_cast<SDL_Keycode>(in.fixed(4));
+            e.key.scancode = static_cast<SDL_Scancode>(in.fixed(2));
+            e.key.mod = static_cast<SDL_Keymod>(in.fixed(2));
+            uint64_t flags = in.fixed(1);
+            e.key.down = (flags & 1) != 0;
+            e.key.repeat = (flags & 2) != 0;
+            break;
+        }
+        case SDL_EVENT_MOUSE_BUTTON_DOWN:
+        case SDL_EVENT_MOUSE_BUTTON_UP:
+            e.button.button = static_cast<Uint8>(in.fixed(1));
+            e.button.clicks = static_cast<Uint8>(in.fixed(1));
+            e.button.x = in.real();
+            e.button.y = in.real();
+            e.button.down = e.type == SDL_EVENT_MOUSE_BUTTON_DOWN;
+            break;
+        case SDL_EVENT_MOUSE_MOTION:
+            e.motion.state = static_cast<SDL_MouseButtonFlags>(in.fixed(4));
+            e.motion.x = in.real();
+            e.motion.y = in.real();
+            e.motion.xrel = in.real();
+            e.motion.yrel = in.real();
+            break;
+        case SDL_EVENT_MOUSE_WHEEL:
+            e.wheel.x = in.real();
+            e.wheel.y = in.real();
+            e.wheel.mouse_x = in.real();
+            e.wheel.mouse_y = in.real();
+            e.wheel.direction = static_cast<SDL_MouseWheelDirection>(in.fixed(1));
+            break;
+        case SDL_EVENT_TEXT_INPUT: {
+            uint64_t length = in.varint();
+            if (!in.ok || static_cast<uint64_t>(end - data) < length) return false;
+            recorded.text.assign(reinterpret_cast<const char*>(data), length);
+            data += length;
+            break;
+        }
+        case SDL_EVENT_FINGER_DOWN:
+        case SDL_EVENT_FINGER_UP:
+        case SDL_EVENT_FINGER_MOTION:
+            e.tfinger.fingerID = static_cast<SDL_FingerID>(in.fixed(8));
+            e.tfinger.x = in.real();
+            e.tfinger.y = in.real();
+            e.tfinger.dx = in.real();
+            e.tfinger.dy = in.real();
+            e.tfinger.pressure = in.real();
+            break;
+        default:
+            break;
+    }
+    return in.ok;
+}
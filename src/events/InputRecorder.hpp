@@ -0,0 +1,69 @@
+#ifndef INPUTRECORDER_HPP
+#define INPUTRECORDER_HPP
+
+#include <SDL3/SDL.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Records the SDL events EventHandler handles and replays them on the same
+// frames, for reproducing interaction-driven performance problems.
+//
+// Events are stored with the frame they arrived in (relative to the start of
+// the recording) and their offset into that frame. Replay pushes each frame's
+// events with SDL_PushEvent at the start of the frame, just before
+// EventHandler polls them, and drops live input so only the recording drives
+// the app. The application runs replays with a fixed delta time.
+//
+// File format (little-endian): "IREC", version byte, varint event count, then
+// per event: varint frame delta, varint offset (us), varint SDL event type
+// and a type-specific payload of only the fields the handlers read.
+class InputRecorder {
+public:
+    enum class Mode { Off, Recording, Replaying };
+
+private:
+    struct RecordedEvent {
+        uint64_t frame = 0;        // Relative to the first recorded/replayed frame
+        uint32_t offsetUs = 0;     // Since the start of that frame
+        SDL_Event event;
+        std::string text;          // Text input (event.text.text points here on replay)
+    };
+
+    // Marks events pushed by the replay (SDL_CommonEvent::reserved)
+    static const Uint32 REPLAY_MARK = 0x52504c59;  // "RPLY"
+
+    Mode mode = Mode::Off;
+    std::vector<RecordedEvent> events;
+    size_t nextEvent = 0;          // Replay position
+    bool started = false;          // First frame seen since start/load
+    uint64_t startFrame = 0;
+    uint64_t frame = 0;            // Current frame, relative
+    Uint64 frameStartNs = 0;
+
+public:
+    void startRecording();
+    // Writes the recording and stops; returns false if the file can't be written
+    bool stopRecording(const std::string& path);
+
+    bool loadReplay(const std::string& path);
+    void stopReplay();
+
+    Mode getMode() const { return mode; }
+    size_t getEventCount() const { return events.size(); }
+    bool isReplayFinished() const { return mode == Mode::Replaying && nextEvent >= events.size(); }
+
+    // Start of a frame, before events are polled (pushes replayed events)
+    void beginFrame(uint64_t frameCounter);
+
+    // Called for every polled event: records it, or during replay drops live
+    // input. Returns whether the event should be handled.
+    bool process(const SDL_Event& event);
+
+private:
+    static bool isRecorded(Uint32 type);
+    static void encode(std::vector<uint8_t>& out, const RecordedEvent& recorded, uint64_t previousFrame);
+    static bool decode(const uint8_t*& data, const uint8_t* end, RecordedEvent& recorded, uint64_t previousFrame);
+};
+
+#endif // INPUTRECORDER_HPP
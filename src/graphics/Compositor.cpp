@@ -0,0 +1,481 @@
+#include "Compositor.hpp"
+#include "../widgets/TextWidget.hpp"
+#include "GlyphAtlas.hpp"
+#include "../core/FrameStats.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// FNV-1a, used to fingerprint draw commands between frames
+const uint64_t FNV_OFFSET = 1469598103934665603ull;
+const uint64_t FNV_PRIME = 1099511628211ull;
+
+uint64_t hashBytes(uint64_t h, const void* data, size_t size) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; i++) {
+        h ^= bytes[i];
+        h *= FNV_PRIME;
+    }
+    return h;
+}
+
+template <typename T>
+uint64_t hashValue(uint64_t h, const T& value) {
+    return hashBytes(h, &value, sizeof(T));
+}
+
+long long rectArea(const SDL_Rect& r) {
+    return static_cast<long long>(r.w) * r.h;
+}
+
+} // namespace
+
+Compositor::~Compositor() {
+    cleanup();
+}
+
+void Compositor::init(SDL_Renderer* r, TTF_TextEngine* te, SlotMap<TextWidget>* w) {
+    renderer = r;
+    textEngine = te;
+    widgets = w;
+}
+
+void Compositor::setDamageTracking(bool enabled) {
+    if (enabled == damageTracking) return;
+    damageTracking = enabled;
+    previousCommands.clear();
+    commands.clear();
+    fullDamage = true;
+    if (!enabled && frameTexture) {
+        SDL_DestroyTexture(frameTexture);
+        frameTexture = nullptr;
+    }
+}
+
+void Compositor::beginFrame(int width, int height, const SDL_FColor& background) {
+    stats = Stats{};
+    commands.clear();
+
+    if (width != frameWidth || height != frameHeight) {
+        frameWidth = width;
+        frameHeight = height;
+        fullDamage = true;
+    }
+    if (background.r != clearColor.r || background.g != clearColor.g ||
+        background.b != clearColor.b || background.a != clearColor.a) {
+        clearColor = background;
+        fullDamage = true;
+    }
+
+    if (!damageTracking && renderer) {
+        SDL_SetRenderDrawColorFloat(renderer, clearColor.r, clearColor.g, clearColor.b, clearColor.a);
+        SDL_RenderClear(renderer);
+    }
+}
+
+void Compositor::endFrame() {
+    stats.commands = static_cast<int>(commands.size());
+    if (!damageTracking || !renderer) return;
+
+    // Without a frame texture, fall back to a full immediate redraw
+    if (!ensureFrameTexture()) {
+        SDL_SetRenderDrawColorFloat(renderer, clearColor.r, clearColor.g, clearColor.b, clearColor.a);
+        SDL_RenderClear(renderer);
+        for (const DrawCommand& command : commands) {
+            execute(command);
+        }
+        stats.replayed = stats.commands;
+        stats.damagedArea = 1.0f;
+        fullDamage = true;
+        commands.clear();
+        return;
+    }
+
+    damage.clear();
+    if (fullDamage) {
+        damage.push_back({0, 0, frameWidth, frameHeight});
+    } else {
+        diffDisplayLists();
+    }
+    mergeDamage();
+
+    // Redraw damaged regions of the persistent frame
+    SDL_Texture* previousTarget = SDL_GetRenderTarget(renderer);
+    SDL_SetRenderTarget(renderer, frameTexture);
+
+    SDL_BlendMode drawBlendMode = SDL_BLENDMODE_NONE;
+    SDL_GetRenderDrawBlendMode(renderer, &drawBlendMode);
+
+    long long damagedPixels = 0;
+    for (const SDL_Rect& rect : damage) {
+        SDL_FRect area = {
+            static_cast<float>(rect.x), static_cast<float>(rect.y),
+            static_cast<float>(rect.w), static_cast<float>(rect.h)
+        };
+        damagedPixels += rectArea(rect);
+
+        SDL_SetRenderClipRect(renderer, &rect);
+
+        // SDL_RenderClear ignores the clip rect, so clear with a fill
+        SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+        SDL_SetRenderDrawColorFloat(renderer, clearColor.r, clearColor.g, clearColor.b, clearColor.a);
+        SDL_RenderFillRect(renderer, &area);
+        SDL_SetRenderDrawBlendMode(renderer, drawBlendMode);
+
+        for (const DrawCommand& command : commands) {
+            if (SDL_HasRectIntersectionFloat(&command.bounds, &area)) {
+                execute(command);
+                stats.replayed++;
+            }
+        }
+    }
+
+    SDL_SetRenderClipRect(renderer, nullptr);
+    SDL_SetRenderTarget(renderer, previousTarget);
+
+    // Present the composed frame (the back buffer is undefined after a present)
+    SDL_RenderTexture(renderer, frameTexture, nullptr, nullptr);
+    frameCounters::drawCalls++;
+
+    if (debugOverlay) {
+        SDL_SetRenderDrawColor(renderer, 255, 0, 255, 255);
+        for (const SDL_Rect& rect : damage) {
+            SDL_FRect outline = {
+                static_cast<float>(rect.x), static_cast<float>(rect.y),
+                static_cast<float>(rect.w), static_cast<float>(rect.h)
+            };
+            SDL_RenderRect(renderer, &outline);
+        }
+    }
+
+    stats.damageRects = static_cast<int>(damage.size());
+    if (frameWidth > 0 && frameHeight > 0) {
+        stats.damagedArea = static_cast<float>(damagedPixels) /
+                            (static_cast<float>(frameWidth) * frameHeight);
+    }
+
+    fullDamage = false;
+    previousCommands.swap(commands);
+    commands.clear();
+}
+
+void Compositor::fillRect(float x, float y, float w, float h, SDL_Color color) {
+    DrawCommand command{};
+    command.type = CommandType::FillRect;
+    command.bounds = {x, y, w, h};
+    command.x1 = x; command.y1 = y; command.x2 = w; command.y2 = h;
+    command.color = color;
+    record(std::move(command));
+}
+
+void Compositor::outlineRect(float x, float y, float w, float h, SDL_Color color) {
+    DrawCommand command{};
+    command.type = CommandType::OutlineRect;
+    command.bounds = {x, y, w, h};
+    command.x1 = x; command.y1 = y; command.x2 = w; command.y2 = h;
+    command.color = color;
+    record(std::move(command));
+}
+
+void Compositor::line(float x1, float y1, float x2, float y2, SDL_Color color) {
+    DrawCommand command{};
+    command.type = CommandType::Line;
+    float minX = std::min(x1, x2), minY = std::min(y1, y2);
+    command.bounds = {minX, minY, std::max(x1, x2) - minX + 1.0f, std::max(y1, y2) - minY + 1.0f};
+    command.x1 = x1; command.y1 = y1; command.x2 = x2; command.y2 = y2;
+    command.color = color;
+    record(std::move(command));
+}
+
+void Compositor::text(TTF_Font* font, std::string_view str, float x, float y, SDL_Color color) {
+    if (!font || !textEngine || !renderer || str.empty()) return;
+
+    if (!damageTracking) {
+        stats.commands++;
+        if (glyphAtlases && glyphAtlases->draw(font, str, x, y, color)) return;
+        TTF_Text* ttfText = TTF_CreateText(textEngine, font, str.data(), str.length());
+        if (!ttfText) return;
+        frameCounters::textObjects++;
+        frameCounters::drawCalls++;
+        TTF_SetTextColor(ttfText, color.r, color.g, color.b, color.a);
+        TTF_DrawRendererText(ttfText, x, y);
+        TTF_DestroyText(ttfText);
+        return;
+    }
+
+    int w = 0, h = 0;
+    TTF_GetStringSize(font, str.data(), str.length(), &w, &h);
+
+    DrawCommand command{};
+    command.type = CommandType::Text;
+    command.bounds = {x, y, static_cast<float>(w), static_cast<float>(h)};
+    command.x1 = x; command.y1 = y;
+    command.color = color;
+    command.font = font;
+    command.text.assign(str.data(), str.size());
+    record(std::move(command));
+}
+
+void Compositor::widget(SlotHandle handle, TextWidget& w) {
+    if (!damageTracking) {
+        w.render();
+        return;
+    }
+
+    DrawCommand command{};
+    command.type = CommandType::Widget;
+    command.bounds = {w.x, w.y, w.width, w.height};
+    command.widget = handle;
+
+    // The widget's content version and cursor state stand in for its pixels
+    uint64_t h = FNV_OFFSET;
+    h = hashValue(h, w.getCacheKey());
+    h = hashValue(h, w.getRenderVersion());
+    h = hashValue(h, w.isCursorVisible());
+    command.hash = h;
+    record(std::move(command));
+}
+
+void Compositor::addDamage(float x, float y, float w, float h) {
+    if (!damageTracking || w <= 0 || h <= 0) return;
+    // An invisible command whose hash never repeats, so the diff damages it
+    DrawCommand command{};
+    command.type = CommandType::Damage;
+    command.bounds = {x, y, w, h};
+    command.hash = hashValue(FNV_OFFSET, ++damageSerial);
+    commands.push_back(std::move(command));
+}
+
+void Compositor::forgetFont(TTF_Font* font) {
+    for (DrawCommand& command : previousCommands) {
+        if (command.type == CommandType::Text && command.font == font) {
+            command.hash = hashValue(FNV_OFFSET, ++damageSerial);
+        }
+    }
+}
+
+void Compositor::record(DrawCommand&& command) {
+    if (!renderer) return;
+
+    if (!damageTracking) {
+        execute(command);
+        stats.commands++;
+        return;
+    }
+
+    if (command.bounds.w <= 0 || command.bounds.h <= 0) return;
+
+    if (command.type != CommandType::Widget) {
+        uint64_t h = FNV_OFFSET;
+        h = hashValue(h, command.type);
+        h = hashValue(h, command.x1);
+        h = hashValue(h, command.y1);
+        h = hashValue(h, command.x2);
+        h = hashValue(h, command.y2);
+        h = hashValue(h, command.color);
+        h = hashValue(h, command.font);
+        h = hashBytes(h, command.text.data(), command.text.size());
+        command.hash = h;
+    }
+    command.hash = hashValue(command.hash, command.bounds);
+    commands.push_back(std::move(command));
+}
+
+void Compositor::execute(const DrawCommand& command) {
+    switch (command.type) {
+        case CommandType::FillRect: {
+            SDL_SetRenderDrawColor(renderer, command.color.r, command.color.g, command.color.b, command.color.a);
+            SDL_FRect rect = {command.x1, command.y1, command.x2, command.y2};
+            SDL_RenderFillRect(renderer, &rect);
+            frameCounters::drawCalls++;
+            break;
+        }
+        case CommandType::OutlineRect: {
+            SDL_SetRenderDrawColor(renderer, command.color.r, command.color.g, command.color.b, command.color.a);
+            SDL_FRect rect = {command.x1, command.y1, command.x2, command.y2};
+            SDL_RenderRect(renderer, &rect);
+            frameCounters::drawCalls++;
+            break;
+        }
+        case CommandType::Line:
+            SDL_SetRenderDrawColor(renderer, command.color.r, command.color.g, command.color.b, command.color.a);
+            SDL_RenderLine(renderer, command.x1, command.y1, command.x2, command.y2);
+            frameCounters::drawCalls++;
+            break;
+        case CommandType::Text: {
+            if (glyphAtlases && glyphAtlases->draw(command.font, command.text, command.x1, command.y1, command.color)) break;
+            TTF_Text* ttfText = TTF_CreateText(textEngine, command.font, command.text.c_str(), command.text.length());
+            if (!ttfText) break;
+            frameCounters::textObjects++;
+            frameCounters::drawCalls++;
+            TTF_SetTextColor(ttfText, command.color.r, command.color.g, command.color.b, command.color.a);
+            TTF_DrawRendererText(ttfText, command.x1, command.y1);
+            TTF_DestroyText(ttfText);
+            break;
+        }
+        case CommandType::Widget:
+            if (widgets) {
+                if (TextWidget* w = widgets->get(command.widget)) {
+                    w->render();
+                }
+            }
+            break;
+        case CommandType::Damage:
+            break;
+    }
+}
+
+void Compositor::diffDisplayLists() {
+    // Match the two lists as a common subsequence (greedy, with a small
+    // lookahead to resynchronise after insertions and removals). Pixels covered
+    // only by matched commands are guaranteed identical to the previous frame;
+    // every unmatched command damages its bounds.
+    const std::vector<DrawCommand>& cur = commands;
+    const std::vector<DrawCommand>& prev = previousCommands;
+    size_t i = 0, j = 0;
+
+    while (i < cur.size() && j < prev.size()) {
+        if (cur[i].hash == prev[j].hash) {
+            i++;
+            j++;
+            continue;
+        }
+
+        size_t skipCur = 1, skipPrev = 1;
+        for (size_t k = 1; k <= DIFF_LOOKAHEAD; k++) {
+            if (j + k < prev.size() && prev[j + k].hash == cur[i].hash) {
+                skipCur = 0;
+                skipPrev = k;
+                break;
+            }
+            if (i + k < cur.size() && cur[i + k].hash == prev[j].hash) {
+                skipCur = k;
+                skipPrev = 0;
+                break;
+            }
+        }
+
+        for (size_t k = 0; k < skipPrev; k++) addDamageRect(prev[j + k].bounds);
+        for (size_t k = 0; k < skipCur; k++) addDamageRect(cur[i + k].bounds);
+        i += skipCur;
+        j += skipPrev;
+    }
+
+    for (; i < cur.size(); i++) addDamageRect(cur[i].bounds);
+    for (; j < prev.size(); j++) addDamageRect(prev[j].bounds);
+}
+
+void Compositor::addDamageRect(const SDL_FRect& bounds) {
+    // Expand to whole pixels plus a 1px margin for antialiased edges
+    int x0 = static_cast<int>(std::floor(bounds.x)) - 1;
+    int y0 = static_cast<int>(std::floor(bounds.y)) - 1;
+    int x1 = static_cast<int>(std::ceil(bounds.x + bounds.w)) + 1;
+    int y1 = static_cast<int>(std::ceil(bounds.y + bounds.h)) + 1;
+
+    x0 = std::max(x0, 0);
+    y0 = std::max(y0, 0);
+    x1 = std::min(x1, frameWidth);
+    y1 = std::min(y1, frameHeight);
+    if (x1 <= x0 || y1 <= y0) return;
+
+    damage.push_back({x0, y0, x1 - x0, y1 - y0});
+}
+
+void Compositor::mergeDamage() {
+    if (damage.size() <= 1) return;
+
+    SDL_Rect screen = {0, 0, frameWidth, frameHeight};
+
+    // Very fragmented damage: a single bounding box is cheaper than merging
+    if (damage.size() > 256) {
+        SDL_Rect bounds = damage[0];
+        for (const SDL_Rect& r : damage) {
+            SDL_Rect u;
+            SDL_GetRectUnion(&bounds, &r, &u);
+            bounds = u;
+        }
+        damage.assign(1, bounds);
+        return;
+    }
+
+    // Merge pairs whose union wastes little area (overlapping or adjacent rects)
+    bool merged = true;
+    while (merged) {
+        merged = false;
+        for (size_t a = 0; a < damage.size() && !merged; a++) {
+            for (size_t b = a + 1; b < damage.size(); b++) {
+                SDL_Rect u;
+                SDL_GetRectUnion(&damage[a], &damage[b], &u);
+                if (rectArea(u) * 4 <= (rectArea(damage[a]) + rectArea(damage[b])) * 5) {
+                    damage[a] = u;
+                    damage.erase(damage.begin() + b);
+                    merged = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    // Cap the number of rects by merging the cheapest pairs
+    while (damage.size() > static_cast<size_t>(MAX_DAMAGE_RECTS)) {
+        size_t bestA = 0, bestB = 1;
+        long long bestGrowth = -1;
+        for (size_t a = 0; a < damage.size(); a++) {
+            for (size_t b = a + 1; b < damage.size(); b++) {
+                SDL_Rect u;
+                SDL_GetRectUnion(&damage[a], &damage[b], &u);
+                long long growth = rectArea(u) - rectArea(damage[a]) - rectArea(damage[b]);
+                if (bestGrowth < 0 || growth < bestGrowth) {
+                    bestGrowth = growth;
+                    bestA = a;
+                    bestB = b;
+                }
+            }
+        }
+        SDL_Rect u;
+        SDL_GetRectUnion(&damage[bestA], &damage[bestB], &u);
+        damage[bestA] = u;
+        damage.erase(damage.begin() + bestB);
+    }
+
+    // Mostly damaged: one full redraw is cheaper than many clipped passes
+    long long total = 0;
+    for (const SDL_Rect& r : damage) total += rectArea(r);
+    if (total * 10 >= rectArea(screen) * 6) {
+        damage.assign(1, screen);
+    }
+}
+
+bool Compositor::ensureFrameTexture() {
+    if (frameWidth <= 0 || frameHeight <= 0) return false;
+
+    if (frameTexture) {
+        float w = 0, h = 0;
+        SDL_GetTextureSize(frameTexture, &w, &h);
+        if (static_cast<int>(w) == frameWidth && static_cast<int>(h) == frameHeight) {
+            return true;
+        }
+        SDL_DestroyTexture(frameTexture);
+        frameTexture = nullptr;
+    }
+
+    frameTexture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888,
+                                     SDL_TEXTUREACCESS_TARGET, frameWidth, frameHeight);
+    if (!frameTexture) return false;
+
+    SDL_SetTextureBlendMode(frameTexture, SDL_BLENDMODE_NONE);
+    SDL_SetTextureScaleMode(frameTexture, SDL_SCALEMODE_NEAREST);
+    fullDamage = true;
+    return true;
+}
+
+void Compositor::cleanup() {
+    if (frameTexture) {
+        SDL_DestroyTexture(frameTexture);
+        frameTexture = nullptr;
+    }
+    commands.clear();
+    previousCommands.clear();
+    fullDamage = true;
+}
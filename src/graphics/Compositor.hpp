@@ -0,0 +1,121 @@
+#ifndef COMPOSITOR_HPP
+#define COMPOSITOR_HPP
+
+#include <SDL3/SDL.h>
+#include <SDL3_ttf/SDL_ttf.h>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../core/SlotMap.hpp"
+
+// Forward declarations
+class TextWidget;
+class GlyphAtlasCache;
+
+// Frame compositor with optional damage tracking.
+//
+// Immediate mode (default): draw calls go straight to the renderer.
+//
+// Damage mode: draw calls are recorded into a display list. At the end of the
+// frame the list is diffed against the previous frame's list; every command
+// that appeared, disappeared or changed contributes its bounds as a damaged
+// rectangle. Damage is merged into a few rectangles and only those regions of
+// a persistent window-sized texture are cleared and replayed under a clip rect
+// before the texture is presented.
+class Compositor {
+public:
+    struct Stats {
+        int commands = 0;        // Commands recorded this frame
+        int damageRects = 0;     // Merged damage rectangles this frame
+        int replayed = 0;        // Commands replayed into damaged regions
+        float damagedArea = 0;   // Fraction of the window redrawn (0-1)
+    };
+
+private:
+    enum class CommandType { FillRect, OutlineRect, Line, Text, Widget, Damage };
+
+    struct DrawCommand {
+        CommandType type;
+        SDL_FRect bounds;        // Screen area touched by the command
+        float x1, y1, x2, y2;    // Rect (x, y, w, h) or line endpoints
+        SDL_Color color;
+        TTF_Font* font;
+        std::string text;
+        SlotHandle widget;
+        uint64_t hash;           // Identity of everything the command draws
+    };
+
+    SDL_Renderer* renderer = nullptr;
+    TTF_TextEngine* textEngine = nullptr;
+    SlotMap<TextWidget>* widgets = nullptr;
+    GlyphAtlasCache* glyphAtlases = nullptr;   // Optional; text draws try it first
+
+    bool damageTracking = false;
+    bool debugOverlay = false;
+
+    std::vector<DrawCommand> commands;
+    std::vector<DrawCommand> previousCommands;
+    std::vector<SDL_Rect> damage;
+
+    SDL_Texture* frameTexture = nullptr;
+    int frameWidth = 0;
+    int frameHeight = 0;
+    SDL_FColor clearColor = {0, 0, 0, 1};
+    bool fullDamage = true;
+    uint64_t damageSerial = 0;
+    Stats stats;
+
+    static const int MAX_DAMAGE_RECTS = 16;
+    static const size_t DIFF_LOOKAHEAD = 8;
+
+public:
+    Compositor() = default;
+    ~Compositor();
+
+    Compositor(const Compositor&) = delete;
+    Compositor& operator=(const Compositor&) = delete;
+
+    void init(SDL_Renderer* r, TTF_TextEngine* te, SlotMap<TextWidget>* w);
+
+    void setGlyphAtlases(GlyphAtlasCache* atlases) { glyphAtlases = atlases; }
+
+    void setDamageTracking(bool enabled);
+    bool isDamageTracking() const { return damageTracking; }
+    void setDebugOverlay(bool enabled) { debugOverlay = enabled; }
+
+    // Frame lifecycle: beginFrame clears the window (immediate mode) or starts
+    // a new display list; endFrame composites damaged regions (damage mode)
+    void beginFrame(int width, int height, const SDL_FColor& background);
+    void endFrame();
+
+    // Draw calls (recorded in damage mode, executed directly otherwise)
+    void fillRect(float x, float y, float w, float h, SDL_Color color);
+    void outlineRect(float x, float y, float w, float h, SDL_Color color);
+    void line(float x1, float y1, float x2, float y2, SDL_Color color);
+    void text(TTF_Font* font, std::string_view str, float x, float y, SDL_Color color);
+    void widget(SlotHandle handle, TextWidget& w);
+
+    // Explicit damage (e.g. content drawn outside the compositor)
+    void addDamage(float x, float y, float w, float h);
+    void invalidate() { fullDamage = true; }
+
+    // A font instance was closed: its address may be reused by another
+    // instance, so text drawn with it last frame must not match next frame
+    void forgetFont(TTF_Font* font);
+
+    Stats getStats() const { return stats; }
+
+    void cleanup();
+
+private:
+    void record(DrawCommand&& command);
+    void execute(const DrawCommand& command);
+    void diffDisplayLists();
+    void addDamageRect(const SDL_FRect& bounds);
+    void mergeDamage();
+    bool ensureFrameTexture();
+};
+
+#endif // COMPOSITOR_HPP
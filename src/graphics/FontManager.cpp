@@ -1,5 +1,8 @@
 #include "FontManager.hpp"
-#include <iostream>
+#include "../core/Trace.hpp"
+#include "../core/Log.hpp"
+#include <algorithm>
+#include <cmath>
 #include <SDL3/SDL.h>
 
 FontManager::~FontManager() {
@@ -7,14 +10,44 @@ FontManager::~FontManager() {
 }
 
 int FontManager::loadFont(const std::string& path, float size) {
-    TTF_Font* font = TTF_OpenFont(path.c_str(), size);
+    std::shared_ptr<FontFile> file = loadFontFile(path);
+    TTF_Font* font = file ? openFontInstance(*file, quantiseSize(size)) : nullptr;
     if (!font) {
-        std::cerr << "Failed to load font: " << path << " - " << SDL_GetError() << std::endl;
+        logging::error("Failed to load font: ", path, " - ", SDL_GetError());
         return -1;
     }
 
+    return registerFont(path, file, font, size);
+}
+
+int FontManager::adoptFont(const std::string& path, void* data, size_t dataSize, uint64_t fileHash, TTF_Font* font, float size) {
+    auto file = std::make_shared<FontFile>();
+    file->data = data;
+    file->size = dataSize;
+    file->hash = fileHash;
+
+    // Later synchronous loads of the same path share this buffer
+    auto fileIt = files.find(path);
+    if (fileIt == files.end() || fileIt->second.expired()) {
+        files[path] = file;
+    }
+
+    return registerFont(path, file, font, size);
+}
+
+int FontManager::registerFont(const std::string& path, std::shared_ptr<FontFile> file, TTF_Font* font, float size) {
     int fontId = nextFontId++;
-    fonts[fontId] = FontEntry{path, {{size, font}}};
+    float opened = quantiseSize(size);
+    FontEntry& entry = fonts[fontId];
+    entry.path = path;
+    entry.file = std::move(file);
+    FontInstance& instance = entry.sizeCache[opened];
+    instance.font = font;
+    instance.lastUse = ++useCounter;
+    instance.lastFrame = currentFrame;
+    instanceIndex[font] = InstanceRef{fontId, opened};
+    instanceCount++;
+    stats.misses++;
 
     // If no current font, set this as current
     if (currentFontId == 0) {
@@ -23,6 +56,7 @@ int FontManager::loadFont(const std::string& path, float size) {
         currentFont = font;
     }
 
+    evictInstances();
     return fontId;
 }
 
@@ -57,12 +91,34 @@ void FontManager::closeFont(int fontId) {
     auto it = fonts.find(fontId);
     if (it == fonts.end()) return;
 
+    // Take the font out of every fallback chain before its instances go away
+    for (auto& [otherId, other] : fonts) {
+        auto& chain = other.fallbacks;
+        if (otherId == fontId || std::find(chain.begin(), chain.end(), fontId) == chain.end()) continue;
+        chain.erase(std::remove(chain.begin(), chain.end(), fontId), chain.end());
+        for (auto& [openedSize, instance] : other.sizeCache) {
+            if (instance.fallbacksAttached) {
+                refreshFallbacks(otherId, openedSize);
+            }
+        }
+    }
+
     // Close all cached sizes
-    for (auto& [size, font] : it->second.sizeCache) {
-        TTF_CloseFont(font);
+    for (auto& [openedSize, instance] : it->second.sizeCache) {
+        detachFallbacks(instance);
+    }
+    for (auto& [openedSize, instance] : it->second.sizeCache) {
+        closeInstance(instance);
     }
+    std::string path = it->second.path;
     fonts.erase(it);
 
+    // Forget the file buffer once no font uses it any more
+    auto fileIt = files.find(path);
+    if (fileIt != files.end() && fileIt->second.expired()) {
+        files.erase(fileIt);
+    }
+
     // Clear current font if it was the one we closed
     if (currentFontId == fontId) {
         currentFontId = 0;
@@ -71,30 +127,323 @@ void FontManager::closeFont(int fontId) {
 }
 
 void FontManager::cleanup() {
+    // Detach everything first so no instance outlives a font it falls back to
     for (auto& [fontId, entry] : fonts) {
-        for (auto& [size, font] : entry.sizeCache) {
-            TTF_CloseFont(font);
+        for (auto& [openedSize, instance] : entry.sizeCache) {
+            detachFallbacks(instance);
+        }
+    }
+    for (auto& [fontId, entry] : fonts) {
+        for (auto& [openedSize, instance] : entry.sizeCache) {
+            closeInstance(instance);
         }
     }
     fonts.clear();
+    files.clear();
+    instanceIndex.clear();
+    instanceCount = 0;
     currentFontId = 0;
     currentFont = nullptr;
 }
 
+void FontManager::setFallbacks(int fontId, const std::vector<int>& chain) {
+    auto it = fonts.find(fontId);
+    if (it == fonts.end()) return;
+
+    std::vector<int>& fallbacks = it->second.fallbacks;
+    fallbacks.clear();
+    for (int fallbackId : chain) {
+        if (fallbackId == fontId || fonts.find(fallbackId) == fonts.end()) continue;
+        if (std::find(fallbacks.begin(), fallbacks.end(), fallbackId) != fallbacks.end()) continue;
+        fallbacks.push_back(fallbackId);
+    }
+
+    for (auto& [openedSize, instance] : it->second.sizeCache) {
+        if (instance.fallbacksAttached) {
+            refreshFallbacks(fontId, openedSize);
+        }
+    }
+}
+
+std::vector<int> FontManager::getFallbacks(int fontId) const {
+    auto it = fonts.find(fontId);
+    return it != fonts.end() ? it->second.fallbacks : std::vector<int>();
+}
+
+bool FontManager::hasGlyph(int fontId, uint32_t codepoint) {
+    const CoveragePage* page = coveragePage(fontId, codepoint >> 8);
+    return page && page->test(codepoint & 0xFF);
+}
+
+int FontManager::resolveFont(int fontId, uint32_t codepoint) {
+    if (hasGlyph(fontId, codepoint)) return fontId;
+
+    auto it = fonts.find(fontId);
+    if (it == fonts.end()) return fontId;
+    for (int fallbackId : it->second.fallbacks) {
+        if (hasGlyph(fallbackId, codepoint)) return fallbackId;
+    }
+    return fontId;  // Nobody has it: draw the primary font's missing glyph
+}
+
+void FontManager::splitRuns(int fontId, const char* text, size_t length, std::vector<TextRun>& runs) {
+    runs.clear();
+    if (length == 0) return;
+
+    auto it = fonts.find(fontId);
+    if (it == fonts.end() || it->second.fallbacks.empty()) {
+        runs.push_back(TextRun{0, length, fontId});
+        return;
+    }
+
+    const char* p = text;
+    size_t remaining = length;
+    size_t runStart = 0;
+    int runFont = fontId;
+
+    while (remaining > 0) {
+        size_t offset = static_cast<size_t>(p - text);
+        Uint32 codepoint = SDL_StepUTF8(&p, &remaining);
+
+        // Whitespace, joiners, variation selectors and combining marks stay
+        // with the run they follow instead of starting a new one
+        bool sticky = codepoint <= 0x20 ||
+                      (codepoint >= 0x0300 && codepoint <= 0x036F) ||
+                      codepoint == 0x200D ||
+                      (codepoint >= 0xFE00 && codepoint <= 0xFE0F) ||
+                      (codepoint >= 0x1F3FB && codepoint <= 0x1F3FF);
+        int face = sticky ? runFont : resolveFont(fontId, codepoint);
+
+        if (face != runFont) {
+            if (offset > runStart) {
+                runs.push_back(TextRun{runStart, offset - runStart, runFont});
+            }
+            runStart = offset;
+            runFont = face;
+        }
+    }
+    runs.push_back(TextRun{runStart, length - runStart, runFont});
+}
+
+void FontManager::attachFallbacks(TTF_Font* font) {
+    auto it = instanceIndex.find(font);
+    if (it == instanceIndex.end()) return;
+    InstanceRef ref = it->second;
+    fonts[ref.fontId].sizeCache[ref.size].fallbacksAttached = true;
+    refreshFallbacks(ref.fontId, ref.size);
+}
+
+void FontManager::pinFont(TTF_Font* font) {
+    auto it = instanceIndex.find(font);
+    if (it == instanceIndex.end()) return;
+    fonts[it->second.fontId].sizeCache[it->second.size].pins++;
+}
+
+void FontManager::unpinFont(TTF_Font* font) {
+    auto it = instanceIndex.find(font);
+    if (it == instanceIndex.end()) return;
+    FontInstance& instance = fonts[it->second.fontId].sizeCache[it->second.size];
+    if (instance.pins > 0) {
+        instance.pins--;
+    }
+    evictInstances();
+}
+
+void FontManager::setCacheLimits(size_t maxFontInstances, float quantum) {
+    maxInstances = maxFontInstances > 0 ? maxFontInstances : 1;
+    // Instances are keyed by the size they were opened at, so existing ones
+    // stay valid; the new quantum applies to lookups from now on
+    sizeQuantum = quantum > 0.0f ? quantum : 0.0f;
+    evictInstances();
+}
+
+FontManager::CacheStats FontManager::getCacheStats() const {
+    CacheStats result = stats;
+    result.instances = instanceCount;
+    result.maxInstances = maxInstances;
+    result.sizeQuantum = sizeQuantum;
+    result.pinned = 0;
+    for (const auto& [fontId, entry] : fonts) {
+        for (const auto& [openedSize, instance] : entry.sizeCache) {
+            if (instance.pins > 0 || instance.font == currentFont) {
+                result.pinned++;
+            }
+        }
+    }
+    return result;
+}
+
+bool FontManager::getInstanceKey(TTF_Font* font, uint64_t& fileHash, float& size) {
+    auto it = instanceIndex.find(font);
+    if (it == instanceIndex.end()) return false;
+
+    fileHash = fonts[it->second.fontId].file->hash;
+    size = it->second.size;
+    return true;
+}
+
 TTF_Font* FontManager::getOrCreateFontAtSize(int fontId, float size) {
+    TRACE_ZONE("FontManager::getOrCreateFontAtSize");
     auto it = fonts.find(fontId);
     if (it == fonts.end()) return nullptr;
 
     auto& entry = it->second;
-    auto sizeIt = entry.sizeCache.find(size);
+    float opened = quantiseSize(size);
+    auto sizeIt = entry.sizeCache.find(opened);
     if (sizeIt != entry.sizeCache.end()) {
-        return sizeIt->second;
+        sizeIt->second.lastUse = ++useCounter;
+        sizeIt->second.lastFrame = currentFrame;
+        stats.hits++;
+        return sizeIt->second.font;
     }
 
-    // Load font at new size
-    TTF_Font* font = TTF_OpenFont(entry.path.c_str(), size);
-    if (font) {
-        entry.sizeCache[size] = font;
-    }
+    // Open the new size from the shared file data
+    TTF_Font* font = openFontInstance(*entry.file, opened);
+    if (!font) return nullptr;
+
+    FontInstance& instance = entry.sizeCache[opened];
+    instance.font = font;
+    instance.lastUse = ++useCounter;
+    instance.lastFrame = currentFrame;
+    instanceIndex[font] = InstanceRef{fontId, opened};
+    instanceCount++;
+    stats.misses++;
+
+    evictInstances();
     return font;
 }
+
+float FontManager::quantiseSize(float size) const {
+    // Without quantisation keep 1/64 pt resolution (FreeType's 26.6 units)
+    float step = sizeQuantum > 0.0f ? sizeQuantum : 1.0f / 64.0f;
+    float quantised = static_cast<float>(std::lround(size / step)) * step;
+    return quantised > step ? quantised : step;
+}
+
+const FontManager::CoveragePage* FontManager::coveragePage(int fontId, uint32_t page) {
+    auto it = fonts.find(fontId);
+    if (it == fonts.end()) return nullptr;
+
+    FontEntry& entry = it->second;
+    auto pageIt = entry.coverage.find(page);
+    if (pageIt != entry.coverage.end()) {
+        return &pageIt->second;
+    }
+
+    // Any size of the face will do for probing
+    TTF_Font* probe = !entry.sizeCache.empty() ? entry.sizeCache.begin()->second.font
+                                               : getOrCreateFontAtSize(fontId, currentFontSize);
+    if (!probe) return nullptr;
+
+    CoveragePage& coverage = entry.coverage[page];
+    for (uint32_t i = 0; i < 256; i++) {
+        coverage[i] = TTF_FontHasGlyph(probe, (page << 8) | i);
+    }
+    return &coverage;
+}
+
+void FontManager::refreshFallbacks(int fontId, float openedSize) {
+    FontEntry& entry = fonts[fontId];
+    auto instanceIt = entry.sizeCache.find(openedSize);
+    if (instanceIt == entry.sizeCache.end()) return;
+    FontInstance& instance = instanceIt->second;
+
+    detachFallbacks(instance);
+
+    // Opening fallback sizes may evict; keep this instance in place meanwhile
+    instance.pins++;
+    for (int fallbackId : entry.fallbacks) {
+        TTF_Font* fallback = getOrCreateFontAtSize(fallbackId, openedSize);
+        if (!fallback || !TTF_AddFallbackFont(instance.font, fallback)) continue;
+        pinFont(fallback);
+        instance.fallbacks.push_back(fallback);
+    }
+    instance.pins--;
+}
+
+void FontManager::detachFallbacks(FontInstance& instance) {
+    if (instance.fallbacks.empty()) return;
+    TTF_ClearFallbackFonts(instance.font);
+    for (TTF_Font* fallback : instance.fallbacks) {
+        // Plain unpin: no eviction while callers may be iterating the cache
+        auto it = instanceIndex.find(fallback);
+        if (it == instanceIndex.end()) continue;
+        FontInstance& pinned = fonts[it->second.fontId].sizeCache[it->second.size];
+        if (pinned.pins > 0) {
+            pinned.pins--;
+        }
+    }
+    instance.fallbacks.clear();
+}
+
+void FontManager::evictInstances() {
+    while (instanceCount > maxInstances) {
+        // Least recently used instance that is not pinned, current or used this frame
+        FontEntry* victimEntry = nullptr;
+        std::map<float, FontInstance>::iterator victim;
+        for (auto& [fontId, entry] : fonts) {
+            for (auto it = entry.sizeCache.begin(); it != entry.sizeCache.end(); ++it) {
+                const FontInstance& instance = it->second;
+                if (instance.pins > 0 || instance.font == currentFont) continue;
+                if (instance.lastFrame == currentFrame) continue;
+                if (!victimEntry || instance.lastUse < victim->second.lastUse) {
+                    victimEntry = &entry;
+                    victim = it;
+                }
+            }
+        }
+        if (!victimEntry) break;  // Everything left is in use
+
+        closeInstance(victim->second);
+        victimEntry->sizeCache.erase(victim);
+        stats.evictions++;
+    }
+}
+
+void FontManager::closeInstance(FontInstance& instance) {
+    if (!instance.font) return;
+    detachFallbacks(instance);
+    if (onInstanceClosed) {
+        onInstanceClosed(instance.font);
+    }
+    instanceIndex.erase(instance.font);
+    TTF_CloseFont(instance.font);
+    instance.font = nullptr;
+    instanceCount--;
+}
+
+std::shared_ptr<FontManager::FontFile> FontManager::loadFontFile(const std::string& path) {
+    auto it = files.find(path);
+    if (it != files.end()) {
+        if (auto file = it->second.lock()) {
+            return file;
+        }
+    }
+
+    auto file = std::make_shared<FontFile>();
+    file->data = SDL_LoadFile(path.c_str(), &file->size);
+    if (!file->data) {
+        return nullptr;
+    }
+    // Hashed while the file is hot in cache rather than on a first draw
+    file->hash = hashFileData(file->data, file->size);
+    files[path] = file;
+    return file;
+}
+
+uint64_t FontManager::hashFileData(const void* data, size_t size) {
+    uint64_t hash = 14695981039346656037ULL;
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+TTF_Font* FontManager::openFontInstance(const FontFile& file, float size) {
+    SDL_IOStream* stream = SDL_IOFromConstMem(file.data, file.size);
+    if (!stream) return nullptr;
+    // closeio = true: the stream is closed with the font, the buffer stays shared
+    return TTF_OpenFontIO(stream, true, size);
+}
@@ -4,20 +4,97 @@
 #include <SDL3_ttf/SDL_ttf.h>
 #include <string>
 #include <map>
+#include <bitset>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
 
 class FontManager {
+public:
+    struct CacheStats {
+        size_t instances = 0;     // Open TTF_Font instances (all fonts, all sizes)
+        size_t pinned = 0;        // Instances currently protected from eviction
+        size_t maxInstances = 0;
+        float sizeQuantum = 0.0f;
+        uint64_t hits = 0;
+        uint64_t misses = 0;      // Lookups that had to open a new instance
+        uint64_t evictions = 0;
+    };
+
+    // A byte range of a UTF-8 string drawn with a single font face
+    struct TextRun {
+        size_t offset;
+        size_t length;
+        int fontId;
+    };
+
 private:
+    // Font file contents, read once and shared by every size instance
+    // (instances parse the face from this buffer through SDL_IOStream)
+    struct FontFile {
+        void* data = nullptr;
+        size_t size = 0;
+        uint64_t hash = 0;        // hashFileData of the contents, set when the file is read
+
+        FontFile() = default;
+        FontFile(const FontFile&) = delete;
+        FontFile& operator=(const FontFile&) = delete;
+        ~FontFile() { SDL_free(data); }
+    };
+
+    // One open font at one (quantised) size
+    struct FontInstance {
+        TTF_Font* font = nullptr;
+        uint64_t lastUse = 0;     // Use counter value of the most recent lookup
+        Uint64 lastFrame = 0;     // Frame of the most recent lookup
+        int pins = 0;             // Explicit pins (widgets, cached layouts, ...)
+
+        // Fallback instances attached with TTF_AddFallbackFont (pinned while attached)
+        std::vector<TTF_Font*> fallbacks;
+        bool fallbacksAttached = false;
+    };
+
+    // Glyph coverage of one face for a block of 256 codepoints
+    using CoveragePage = std::bitset<256>;
+
     struct FontEntry {
         std::string path;
-        std::map<float, TTF_Font*> sizeCache;  // size -> font instance
+        std::shared_ptr<FontFile> file;
+        std::map<float, FontInstance> sizeCache;  // Opened (quantised) size -> font instance
+        std::vector<int> fallbacks;              // Fallback chain (font IDs, in order)
+
+        // Coverage is size independent; pages are probed once, on first use
+        std::unordered_map<uint32_t, CoveragePage> coverage;
+    };
+
+    // Reverse lookup for pinning by font pointer
+    struct InstanceRef {
+        int fontId;
+        float size;               // Key in sizeCache
     };
 
     std::map<int, FontEntry> fonts;  // fontId -> FontEntry
+    std::map<std::string, std::weak_ptr<FontFile>> files;  // path -> shared file data
+    std::unordered_map<TTF_Font*, InstanceRef> instanceIndex;
     int nextFontId = 1;
     int currentFontId = 0;
     float currentFontSize = 16.0f;
     TTF_Font* currentFont = nullptr;
 
+    // Bounded instance cache: sizes are quantised into buckets and the least
+    // recently used unpinned instance is closed once the budget is exceeded.
+    // Instances used in the current frame count as pinned.
+    float sizeQuantum = 0.5f;
+    size_t maxInstances = 32;
+    size_t instanceCount = 0;
+    uint64_t useCounter = 0;
+    Uint64 currentFrame = 0;
+    CacheStats stats;
+
+    // Notified before an instance is closed (caches keyed by TTF_Font*)
+    std::function<void(TTF_Font*)> onInstanceClosed;
+
 public:
     FontManager() = default;
     ~FontManager();
@@ -25,6 +102,17 @@ public:
     // Load a font and return its ID
     int loadFont(const std::string& path, float size);
 
+    // Register a font opened elsewhere (e.g. by the AssetLoader) from a file
+    // buffer allocated with SDL_malloc; takes ownership of both
+    // (fileHash: hashFileData of the buffer, computed by the loading thread)
+    int adoptFont(const std::string& path, void* data, size_t dataSize, uint64_t fileHash, TTF_Font* font, float size);
+
+    // FNV-1a of font file contents, the identity getInstanceKey reports (any thread)
+    static uint64_t hashFileData(const void* data, size_t size);
+
+    // Size a font instance is actually opened at for a requested size
+    float quantiseSize(float size) const;
+
     // Get a font at a specific size
     TTF_Font* getFont(int fontId, float size);
 
@@ -49,9 +137,67 @@ public:
     // Close all fonts
     void cleanup();
 
+    // Fallback chains: glyphs missing from a font are taken from the first
+    // font in its chain that has them (chains are not followed recursively)
+    void setFallbacks(int fontId, const std::vector<int>& chain);
+    std::vector<int> getFallbacks(int fontId) const;
+
+    // Whether a font has a glyph, from the cached coverage index
+    bool hasGlyph(int fontId, uint32_t codepoint);
+
+    // Font in fontId's chain that should draw a codepoint (fontId if none has it)
+    int resolveFont(int fontId, uint32_t codepoint);
+
+    // Split UTF-8 text into runs that can each be drawn with one face
+    void splitRuns(int fontId, const char* text, size_t length, std::vector<TextRun>& runs);
+
+    // Attach fontId's fallback chain to an instance through SDL_ttf so that
+    // TTF_Text objects on it (text widgets) pick up fallback glyphs too
+    void attachFallbacks(TTF_Font* font);
+
+    // Protect a font instance from eviction while something holds on to it
+    void pinFont(TTF_Font* font);
+    void unpinFont(TTF_Font* font);
+
+    // Frame bookkeeping: instances looked up during the frame are not evicted
+    void beginFrame(Uint64 frame) { currentFrame = frame; }
+
+    // Cache configuration (quantum <= 0 disables size quantisation)
+    void setCacheLimits(size_t maxFontInstances, float quantum);
+
+    CacheStats getCacheStats() const;
+
+    // Identity of an open instance that survives restarts: a hash of the font
+    // file contents and the size the instance was opened at
+    bool getInstanceKey(TTF_Font* font, uint64_t& fileHash, float& size);
+
+    void setInstanceClosedCallback(std::function<void(TTF_Font*)> callback) {
+        onInstanceClosed = std::move(callback);
+    }
+
 private:
+    // Add a new font entry with its first instance and return its ID
+    int registerFont(const std::string& path, std::shared_ptr<FontFile> file, TTF_Font* font, float size);
+
     // Helper to get or create a font at a specific size
     TTF_Font* getOrCreateFontAtSize(int fontId, float size);
+
+    // Coverage page of a face, built on first use
+    const CoveragePage* coveragePage(int fontId, uint32_t page);
+
+    // Re-attach (or detach) the fallback instances of one instance
+    void refreshFallbacks(int fontId, float openedSize);
+    void detachFallbacks(FontInstance& instance);
+
+    // Close least recently used unpinned instances until within budget
+    void evictInstances();
+    void closeInstance(FontInstance& instance);
+
+    // Read a font file, reusing the buffer if the file is already loaded
+    std::shared_ptr<FontFile> loadFontFile(const std::string& path);
+
+    // Open a font instance at a size from shared file data (no file access)
+    static TTF_Font* openFontInstance(const FontFile& file, float size);
 };
 
 #endif // FONTMANAGER_HPP
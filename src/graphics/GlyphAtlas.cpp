@@ -0,0 +1,483 @@
+#include "GlyphAtlas.hpp"
+#include "FontManager.hpp"
+#include "../core/FrameStats.hpp"
+#include "../core/Log.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+// Metrics file layout (native byte order: the cache is per machine)
+const uint32_t ATLAS_MAGIC = 0x414C4731;  // "1GLA"
+const uint32_t ATLAS_VERSION = 2;         // 2: colour flag, primary font glyphs only
+const int16_t GLYPH_COLOR = 1;             // AtlasFileGlyph::flags
+
+struct AtlasFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t fileHash;
+    int32_t sizeKey;
+    int32_t hinting;
+    int32_t width;
+    int32_t height;
+    int32_t penX;
+    int32_t penY;
+    int32_t rowHeight;
+    uint32_t glyphCount;
+};
+
+struct AtlasFileGlyph {
+    uint32_t codepoint;
+    int16_t x, y, w, h;
+    int16_t advance;
+    int16_t flags;
+};
+
+// Characters SDL_ttf lays out one glyph after another with only kerning: no
+// combining marks, joining, reordering, right-to-left runs or invisible
+// format characters. Anything else needs the shaper (TTF_Text)
+bool isSimpleCodepoint(uint32_t cp) {
+    if (cp < 0x20 || cp == 0x7F || cp == 0xAD) return false;  // Controls, soft hyphen
+    if (cp < 0x0300) return true;                   // Latin, Latin-1, Latin Extended, IPA
+    if (cp < 0x0370) return false;                  // Combining diacritical marks
+    if (cp < 0x0483) return true;                   // Greek, Cyrillic
+    if (cp < 0x048A) return false;                  // Cyrillic combining marks
+    if (cp < 0x0530) return true;                   // Cyrillic, Cyrillic Supplement
+    if (cp >= 0x2010 && cp < 0x2028) return true;   // Dashes, quotes, bullets, ellipsis
+    if (cp >= 0x2030 && cp < 0x205F) return true;   // Per mille, primes, other punctuation
+    if (cp >= 0x20A0 && cp < 0x20C1) return true;   // Currency signs
+    return false;
+}
+
+// Standard ligatures the shaper would substitute (fi, fl, ff, ffi, ...)
+bool formsLigature(uint32_t cp, uint32_t next) {
+    return cp == 'f' && ((next >= 'a' && next <= 'z') || (next >= 'A' && next <= 'Z'));
+}
+
+// Blended glyphs are rendered white, so any other colour is from the font
+bool hasColor(const SDL_Surface* surface) {
+    for (int y = 0; y < surface->h; y++) {
+        const Uint8* bytes = static_cast<const Uint8*>(surface->pixels) + y * surface->pitch;
+        const Uint32* row = reinterpret_cast<const Uint32*>(bytes);
+        for (int x = 0; x < surface->w; x++) {
+            if ((row[x] >> 24) != 0 && (row[x] & 0xFFFFFF) != 0xFFFFFF) return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+GlyphAtlasCache::~GlyphAtlasCache() {
+    cleanup();
+}
+
+void GlyphAtlasCache::init(SDL_Renderer* r, FontManager* f) {
+    renderer = r;
+    fonts = f;
+}
+
+void GlyphAtlasCache::setDirectory(const std::string& dir) {
+    if (dir == directory) return;
+    save();
+    cleanup();
+    directory = dir;
+    if (directory.empty()) return;
+    if (!SDL_CreateDirectory(directory.c_str())) {
+        logging::warn("Glyph cache directory unavailable: ", directory, " - ", SDL_GetError());
+        return;
+    }
+    preload();
+}
+
+void GlyphAtlasCache::preload() {
+    // Decode and upload every saved atlas now, so the first frames that draw
+    // text only bind fonts to atlases that are already resident
+    int count = 0;
+    char** names = SDL_GlobDirectory(directory.c_str(), "*.glyphs", 0, &count);
+    if (!names) return;
+    for (int i = 0; i < count; i++) {
+        std::string name = names[i];
+        name.resize(name.size() - std::strlen(".glyphs"));
+
+        unsigned long long fileHash = 0;
+        int sizeKey = 0, hinting = 0;
+        if (std::sscanf(name.c_str(), "%16llx-%d-h%d", &fileHash, &sizeKey, &hinting) != 3) continue;
+        if (atlases.count(name)) continue;
+
+        auto atlas = std::make_unique<Atlas>();
+        atlas->name = name;
+        atlas->fileHash = fileHash;
+        atlas->sizeKey = sizeKey;
+        atlas->hinting = hinting;
+        if (!loadAtlas(*atlas)) continue;
+        ensureTexture(*atlas);
+        stats.diskLoads++;
+        atlases[name] = std::move(atlas);
+    }
+    SDL_free(names);
+}
+
+int GlyphAtlasCache::prewarm(TTF_Font* font, const std::string& charset) {
+    Atlas* atlas = atlasFor(font);
+    if (!atlas) return 0;
+
+    decode(charset);
+    int added = 0;
+    for (uint32_t codepoint : codepoints) {
+        if (codepoint < 0x20 || atlas->glyphs.count(codepoint)) continue;
+        if (addGlyph(*atlas, codepoint)) {
+            added++;
+        }
+    }
+    ensureTexture(*atlas);
+    return added;
+}
+
+bool GlyphAtlasCache::draw(TTF_Font* font, std::string_view str, float x, float y, SDL_Color color) {
+    Atlas* atlas = atlasFor(font);
+    if (!atlas) return false;
+
+    if (!decode(str)) {
+        stats.fallbackDraws++;
+        return false;
+    }
+    for (size_t i = 0; i < codepoints.size(); i++) {
+        uint32_t codepoint = codepoints[i];
+        if (i + 1 < codepoints.size() && formsLigature(codepoint, codepoints[i + 1])) {
+            stats.fallbackDraws++;
+            return false;
+        }
+        bool cached = atlas->glyphs.count(codepoint) || addGlyph(*atlas, codepoint);
+        // Colour glyphs must not be tinted with the text colour
+        if (!cached || atlas->glyphs[codepoint].color) {
+            stats.fallbackDraws++;
+            return false;
+        }
+    }
+    if (!ensureTexture(*atlas)) return false;
+
+    SDL_SetTextureColorMod(atlas->texture, color.r, color.g, color.b);
+    SDL_SetTextureAlphaMod(atlas->texture, color.a);
+
+    float penX = x;
+    uint32_t previous = 0;
+    for (uint32_t codepoint : codepoints) {
+        const Glyph& glyph = atlas->glyphs[codepoint];
+        int kerning = 0;
+        if (previous && TTF_GetGlyphKerning(font, previous, codepoint, &kerning)) {
+            penX += kerning;
+        }
+        if (glyph.w > 0 && glyph.h > 0) {
+            SDL_FRect src = {static_cast<float>(glyph.x), static_cast<float>(glyph.y),
+                             static_cast<float>(glyph.w), static_cast<float>(glyph.h)};
+            SDL_FRect dst = {penX, y, static_cast<float>(glyph.w), static_cast<float>(glyph.h)};
+            SDL_RenderTexture(renderer, atlas->texture, &src, &dst);
+            frameCounters::drawCalls++;
+        }
+        penX += glyph.advance;
+        previous = codepoint;
+    }
+
+    stats.atlasDraws++;
+    return true;
+}
+
+void GlyphAtlasCache::forgetFont(TTF_Font* font) {
+    auto it = bound.find(font);
+    if (it == bound.end()) return;
+    it->second->font = nullptr;
+    bound.erase(it);
+}
+
+void GlyphAtlasCache::invalidateTextures() {
+    for (auto& [name, atlas] : atlases) {
+        if (atlas->texture) {
+            SDL_DestroyTexture(atlas->texture);
+            atlas->texture = nullptr;
+        }
+        atlas->textureDirty = true;
+    }
+}
+
+void GlyphAtlasCache::save() {
+    if (directory.empty()) return;
+    for (auto& [name, atlas] : atlases) {
+        if (atlas->diskDirty && saveAtlas(*atlas)) {
+            atlas->diskDirty = false;
+            stats.diskSaves++;
+        }
+    }
+}
+
+GlyphAtlasCache::Stats GlyphAtlasCache::getStats() const {
+    Stats result = stats;
+    result.atlases = atlases.size();
+    result.glyphs = 0;
+    for (const auto& [name, atlas] : atlases) {
+        result.glyphs += atlas->glyphs.size();
+    }
+    return result;
+}
+
+void GlyphAtlasCache::cleanup() {
+    for (auto& [name, atlas] : atlases) {
+        destroyAtlas(*atlas);
+    }
+    atlases.clear();
+    bound.clear();
+}
+
+GlyphAtlasCache::Atlas* GlyphAtlasCache::atlasFor(TTF_Font* font) {
+    if (directory.empty() || !font || !fonts) return nullptr;
+
+    auto it = bound.find(font);
+    if (it != bound.end()) return it->second;
+
+    uint64_t fileHash = 0;
+    float size = 0.0f;
+    if (!fonts->getInstanceKey(font, fileHash, size)) return nullptr;
+
+    int32_t sizeKey = static_cast<int32_t>(std::lround(size * 64.0f));
+    int32_t hinting = static_cast<int32_t>(TTF_GetFontHinting(font));
+    char name[64];
+    std::snprintf(name, sizeof(name), "%016llx-%d-h%d",
+                  static_cast<unsigned long long>(fileHash), sizeKey, hinting);
+
+    std::unique_ptr<Atlas>& slot = atlases[name];
+    if (!slot) {
+        slot = std::make_unique<Atlas>();
+        slot->name = name;
+        slot->fileHash = fileHash;
+        slot->sizeKey = sizeKey;
+        slot->hinting = hinting;
+        if (loadAtlas(*slot)) {
+            stats.diskLoads++;
+        }
+    }
+
+    slot->font = font;
+    bound[font] = slot.get();
+    return slot.get();
+}
+
+bool GlyphAtlasCache::decode(std::string_view str) {
+    codepoints.clear();
+    const char* p = str.data();
+    size_t remaining = str.size();
+    bool drawable = true;
+    while (remaining > 0) {
+        Uint32 codepoint = SDL_StepUTF8(&p, &remaining);
+        // Line breaks, tabs and anything the shaper would change need SDL_ttf
+        if (!isSimpleCodepoint(codepoint)) {
+            drawable = false;
+        }
+        codepoints.push_back(codepoint);
+    }
+    return drawable;
+}
+
+bool GlyphAtlasCache::addGlyph(Atlas& atlas, uint32_t codepoint) {
+    // Glyphs from fallback fonts are left to SDL_ttf's fallback handling
+    if (!atlas.font || !TTF_FontHasGlyph(atlas.font, codepoint)) return false;
+
+    int advance = 0;
+    if (!TTF_GetGlyphMetrics(atlas.font, codepoint, nullptr, nullptr, nullptr, nullptr, &advance)) {
+        return false;
+    }
+
+    // Rendered like a one-character string: full line height, drawn at the pen
+    SDL_Surface* rendered = TTF_RenderGlyph_Blended(atlas.font, codepoint, SDL_Color{255, 255, 255, 255});
+    if (!rendered) return false;
+    SDL_Surface* glyphSurface = SDL_ConvertSurface(rendered, SDL_PIXELFORMAT_ARGB8888);
+    SDL_DestroySurface(rendered);
+    if (!glyphSurface) return false;
+
+    int w = glyphSurface->w;
+    int h = glyphSurface->h;
+    bool color = hasColor(glyphSurface);
+    if (w > ATLAS_WIDTH) {
+        SDL_DestroySurface(glyphSurface);
+        return false;
+    }
+
+    // Shelf packing
+    if (atlas.penX + w > ATLAS_WIDTH) {
+        atlas.penX = 0;
+        atlas.penY += atlas.rowHeight + 1;
+        atlas.rowHeight = 0;
+    }
+    if (!atlas.surface || atlas.penY + h > atlas.surface->h) {
+        if (!growSurface(atlas, atlas.penY + h)) {
+            SDL_DestroySurface(glyphSurface);
+            return false;
+        }
+    }
+
+    SDL_Rect dst = {atlas.penX, atlas.penY, w, h};
+    SDL_SetSurfaceBlendMode(glyphSurface, SDL_BLENDMODE_NONE);
+    SDL_BlitSurface(glyphSurface, nullptr, atlas.surface, &dst);
+    SDL_DestroySurface(glyphSurface);
+
+    atlas.glyphs[codepoint] = Glyph{
+        static_cast<int16_t>(dst.x), static_cast<int16_t>(dst.y),
+        static_cast<int16_t>(w), static_cast<int16_t>(h), static_cast<int16_t>(advance), color
+    };
+    atlas.penX += w + 1;
+    atlas.rowHeight = std::max(atlas.rowHeight, h);
+    atlas.textureDirty = true;
+    atlas.diskDirty = true;
+    stats.rasterised++;
+    return true;
+}
+
+bool GlyphAtlasCache::growSurface(Atlas& atlas, int minHeight) {
+    int height = atlas.surface ? atlas.surface->h : 256;
+    while (height < minHeight) {
+        height *= 2;
+    }
+    if (height > MAX_ATLAS_HEIGHT) return false;
+    if (atlas.surface && height == atlas.surface->h) return true;
+
+    SDL_Surface* grown = SDL_CreateSurface(ATLAS_WIDTH, height, SDL_PIXELFORMAT_ARGB8888);
+    if (!grown) return false;
+    if (atlas.surface) {
+        SDL_SetSurfaceBlendMode(atlas.surface, SDL_BLENDMODE_NONE);
+        SDL_BlitSurface(atlas.surface, nullptr, grown, nullptr);
+        SDL_DestroySurface(atlas.surface);
+    }
+    atlas.surface = grown;
+
+    // Size changed: the texture is recreated on the next upload
+    if (atlas.texture) {
+        SDL_DestroyTexture(atlas.texture);
+        atlas.texture = nullptr;
+    }
+    atlas.textureDirty = true;
+    return true;
+}
+
+bool GlyphAtlasCache::ensureTexture(Atlas& atlas) {
+    if (!atlas.surface) return false;
+    if (atlas.texture && !atlas.textureDirty) return true;
+
+    if (!atlas.texture) {
+        atlas.texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC,
+                                          atlas.surface->w, atlas.surface->h);
+        if (!atlas.texture) return false;
+        SDL_SetTextureBlendMode(atlas.texture, SDL_BLENDMODE_BLEND);
+    }
+    SDL_UpdateTexture(atlas.texture, nullptr, atlas.surface->pixels, atlas.surface->pitch);
+    atlas.textureDirty = false;
+    return true;
+}
+
+bool GlyphAtlasCache::loadAtlas(Atlas& atlas) {
+    size_t dataSize = 0;
+    void* data = SDL_LoadFile(pathFor(atlas, ".glyphs").c_str(), &dataSize);
+    if (!data) return false;
+
+    // Anything that does not match exactly is ignored and rebuilt
+    AtlasFileHeader header;
+    bool valid = dataSize >= sizeof(header);
+    if (valid) {
+        std::memcpy(&header, data, sizeof(header));
+        valid = header.magic == ATLAS_MAGIC && header.version == ATLAS_VERSION &&
+                header.fileHash == atlas.fileHash && header.sizeKey == atlas.sizeKey &&
+                header.hinting == atlas.hinting &&
+                dataSize == sizeof(header) + header.glyphCount * sizeof(AtlasFileGlyph);
+    }
+
+    SDL_Surface* surface = nullptr;
+    if (valid) {
+        if (SDL_Surface* loaded = SDL_LoadBMP(pathFor(atlas, ".bmp").c_str())) {
+            surface = SDL_ConvertSurface(loaded, SDL_PIXELFORMAT_ARGB8888);
+            SDL_DestroySurface(loaded);
+        }
+        valid = surface && surface->w == header.width && surface->h == header.height;
+    }
+
+    if (valid) {
+        const unsigned char* records = static_cast<const unsigned char*>(data) + sizeof(header);
+        for (uint32_t i = 0; i < header.glyphCount; i++) {
+            AtlasFileGlyph record;
+            std::memcpy(&record, records + i * sizeof(record), sizeof(record));
+            if (record.x < 0 || record.y < 0 || record.x + record.w > surface->w || record.y + record.h > surface->h) {
+                valid = false;
+                break;
+            }
+            atlas.glyphs[record.codepoint] = Glyph{record.x, record.y, record.w, record.h, record.advance,
+                                                   (record.flags & GLYPH_COLOR) != 0};
+        }
+    }
+    SDL_free(data);
+
+    if (!valid) {
+        if (surface) SDL_DestroySurface(surface);
+        atlas.glyphs.clear();
+        return false;
+    }
+
+    atlas.surface = surface;
+    atlas.penX = header.penX;
+    atlas.penY = header.penY;
+    atlas.rowHeight = header.rowHeight;
+    atlas.textureDirty = true;
+    atlas.diskDirty = false;
+    return true;
+}
+
+bool GlyphAtlasCache::saveAtlas(Atlas& atlas) {
+    if (!atlas.surface) return false;
+
+    // Pixels first: the metrics file is what marks an atlas as complete
+    if (!SDL_SaveBMP(atlas.surface, pathFor(atlas, ".bmp").c_str())) {
+        logging::error("Failed to save glyph atlas: ", SDL_GetError());
+        return false;
+    }
+
+    AtlasFileHeader header = {};
+    header.magic = ATLAS_MAGIC;
+    header.version = ATLAS_VERSION;
+    header.fileHash = atlas.fileHash;
+    header.sizeKey = atlas.sizeKey;
+    header.hinting = atlas.hinting;
+    header.width = atlas.surface->w;
+    header.height = atlas.surface->h;
+    header.penX = atlas.penX;
+    header.penY = atlas.penY;
+    header.rowHeight = atlas.rowHeight;
+    header.glyphCount = static_cast<uint32_t>(atlas.glyphs.size());
+
+    std::vector<unsigned char> buffer(sizeof(header) + atlas.glyphs.size() * sizeof(AtlasFileGlyph));
+    std::memcpy(buffer.data(), &header, sizeof(header));
+    size_t offset = sizeof(header);
+    for (const auto& [codepoint, glyph] : atlas.glyphs) {
+        AtlasFileGlyph record = {codepoint, glyph.x, glyph.y, glyph.w, glyph.h, glyph.advance,
+                                 glyph.color ? GLYPH_COLOR : int16_t(0)};
+        std::memcpy(buffer.data() + offset, &record, sizeof(record));
+        offset += sizeof(record);
+    }
+
+    SDL_IOStream* stream = SDL_IOFromFile(pathFor(atlas, ".glyphs").c_str(), "wb");
+    if (!stream) return false;
+    bool written = SDL_WriteIO(stream, buffer.data(), buffer.size()) == buffer.size();
+    return SDL_CloseIO(stream) && written;
+}
+
+std::string GlyphAtlasCache::pathFor(const Atlas& atlas, const char* extension) const {
+    return directory + "/" + atlas.name + extension;
+}
+
+void GlyphAtlasCache::destroyAtlas(Atlas& atlas) {
+    if (atlas.texture) {
+        SDL_DestroyTexture(atlas.texture);
+        atlas.texture = nullptr;
+    }
+    if (atlas.surface) {
+        SDL_DestroySurface(atlas.surface);
+        atlas.surface = nullptr;
+    }
+}
@@ -0,0 +1,125 @@
+#ifndef GLYPHATLAS_HPP
+#define GLYPHATLAS_HPP
+
+#include <SDL3/SDL.h>
+#include <SDL3_ttf/SDL_ttf.h>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Forward declaration
+class FontManager;
+
+// Optional persistent glyph cache for simple text draws.
+//
+// Each (font file hash, size, hinting) gets an atlas of rasterised glyphs
+// that is drawn with one texture. Atlases are saved to a cache directory
+// (a BMP plus a binary metrics file) and loaded from there on the next run,
+// so glyphs are not rasterised again after a cold start. Saved atlases are
+// preloaded when the directory is set; the font file hash is computed when
+// the file is read (FontManager), so a first draw only looks up its atlas.
+// A changed font file hashes differently and simply gets a new atlas.
+//
+// Only text that needs no shaping is drawn from the atlas: characters from
+// simple scripts (Latin, Greek, Cyrillic, common punctuation) that the
+// primary font covers, without standard ligatures or colour glyphs. Anything
+// else (line breaks, combining marks, complex or right-to-left scripts,
+// fallback fonts, emoji) is drawn with SDL_ttf text as before.
+class GlyphAtlasCache {
+public:
+    struct Stats {
+        size_t atlases = 0;
+        size_t glyphs = 0;
+        uint64_t rasterised = 0;     // Glyphs rendered with SDL_ttf into an atlas
+        uint64_t diskLoads = 0;      // Atlases read from the cache directory
+        uint64_t diskSaves = 0;
+        uint64_t atlasDraws = 0;     // Strings drawn from an atlas
+        uint64_t fallbackDraws = 0;  // Strings left to SDL_ttf
+    };
+
+private:
+    struct Glyph {
+        int16_t x, y, w, h;          // Rect in the atlas surface
+        int16_t advance;
+        bool color;                  // Colour glyph (emoji): never tinted, left to SDL_ttf
+    };
+
+    struct Atlas {
+        std::string name;            // File stem: <file hash>-<size * 64>-h<hinting>
+        uint64_t fileHash = 0;
+        int32_t sizeKey = 0;
+        int32_t hinting = 0;
+        TTF_Font* font = nullptr;    // Instance used to rasterise missing glyphs
+        SDL_Surface* surface = nullptr;
+        SDL_Texture* texture = nullptr;
+        int penX = 0, penY = 0, rowHeight = 0;
+        bool textureDirty = true;
+        bool diskDirty = false;
+        std::unordered_map<uint32_t, Glyph> glyphs;
+    };
+
+    SDL_Renderer* renderer = nullptr;
+    FontManager* fonts = nullptr;
+    std::string directory;           // Empty: cache disabled
+
+    std::map<std::string, std::unique_ptr<Atlas>> atlases;
+    std::unordered_map<TTF_Font*, Atlas*> bound;
+    std::vector<uint32_t> codepoints;
+    Stats stats;
+
+    static const int ATLAS_WIDTH = 1024;
+    static const int MAX_ATLAS_HEIGHT = 4096;
+
+public:
+    GlyphAtlasCache() = default;
+    ~GlyphAtlasCache();
+
+    GlyphAtlasCache(const GlyphAtlasCache&) = delete;
+    GlyphAtlasCache& operator=(const GlyphAtlasCache&) = delete;
+
+    void init(SDL_Renderer* r, FontManager* f);
+
+    // Enable the cache with a directory for atlas files ("" disables it);
+    // atlases saved there are loaded and uploaded right away
+    void setDirectory(const std::string& dir);
+    bool isEnabled() const { return !directory.empty(); }
+
+    // Make sure every character of `charset` is in the font's atlas and
+    // upload it; returns the number of glyphs that had to be rasterised
+    int prewarm(TTF_Font* font, const std::string& charset);
+
+    // Draw a single-line string from the atlas; false if the caller should
+    // draw it with SDL_ttf instead
+    bool draw(TTF_Font* font, std::string_view str, float x, float y, SDL_Color color);
+
+    // Font instance closed: keep its atlas, drop the pointer
+    void forgetFont(TTF_Font* font);
+
+    // Textures were lost (render device reset); re-upload from the surfaces
+    void invalidateTextures();
+
+    // Write atlases that gained glyphs to the cache directory
+    void save();
+
+    Stats getStats() const;
+
+    void cleanup();
+
+private:
+    void preload();
+    Atlas* atlasFor(TTF_Font* font);
+    bool decode(std::string_view str);
+    bool addGlyph(Atlas& atlas, uint32_t codepoint);
+    bool growSurface(Atlas& atlas, int minHeight);
+    bool ensureTexture(Atlas& atlas);
+    bool loadAtlas(Atlas& atlas);
+    bool saveAtlas(Atlas& atlas);
+    std::string pathFor(const Atlas& atlas, const char* extension) const;
+    static void destroyAtlas(Atlas& atlas);
+};
+
+#endif // GLYPHATLAS_HPP
@@ -0,0 +1,100 @@
+#include "PerfOverlay.hpp"
+#include <algorithm>
+#include <cstdio>
+
+namespace {
+
+const SDL_Color BAR_COLORS[4] = {
+    {80, 160, 255, 255},   // update
+    {120, 220, 120, 255},  // render
+    {240, 200, 80, 255},   // present
+    {240, 90, 90, 255},    // GC
+};
+
+const float LINE_HEIGHT = 10.0f;  // SDL debug font is 8x8
+
+} // namespace
+
+void PerfOverlay::push(const FrameStats& stats) {
+    history[head] = stats;
+    head = (head + 1) % HISTORY;
+    count = std::min(count + 1, HISTORY);
+}
+
+void PerfOverlay::draw(SDL_Renderer* renderer, const FrameStats& current, const Info& info) {
+    if (!visible || !renderer) return;
+
+    const float left = 10.0f, top = 10.0f, padding = 6.0f;
+    const float graphWidth = static_cast<float>(HISTORY * BAR_WIDTH);
+    const float textTop = top + padding + GRAPH_HEIGHT + padding;
+    SDL_FRect panel = {left, top, graphWidth + 2 * padding, GRAPH_HEIGHT + 5 * LINE_HEIGHT + 3 * padding};
+
+    SDL_BlendMode previousBlend = SDL_BLENDMODE_NONE;
+    SDL_GetRenderDrawBlendMode(renderer, &previousBlend);
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 190);
+    SDL_RenderFillRect(renderer, &panel);
+
+    // Stacked bars, oldest on the left
+    for (auto& list : bars) list.clear();
+    const float baseline = top + padding + GRAPH_HEIGHT;
+    for (int i = 0; i < count; i++) {
+        const FrameStats& frame = history[(head - count + i + HISTORY) % HISTORY];
+        const double parts[4] = {frame.updateMs, frame.renderMs, frame.presentMs, frame.gcMs};
+        float x = left + padding + graphWidth - (count - i) * BAR_WIDTH;
+        float y = baseline;
+        for (int p = 0; p < 4; p++) {
+            float h = std::min(static_cast<float>(parts[p]) * PIXELS_PER_MS, y - (top + padding));
+            if (h <= 0.0f) continue;
+            y -= h;
+            bars[p].push_back(SDL_FRect{x, y, static_cast<float>(BAR_WIDTH), h});
+        }
+    }
+    for (int p = 0; p < 4; p++) {
+        if (bars[p].empty()) continue;
+        const SDL_Color& c = BAR_COLORS[p];
+        SDL_SetRenderDrawColor(renderer, c.r, c.g, c.b, c.a);
+        SDL_RenderFillRects(renderer, bars[p].data(), static_cast<int>(bars[p].size()));
+    }
+
+    // 16.7 ms (60 Hz) reference line
+    float budgetY = baseline - 16.7f * PIXELS_PER_MS;
+    SDL_SetRenderDrawColor(renderer, 255, 255, 255, 120);
+    SDL_RenderLine(renderer, left + padding, budgetY, left + padding + graphWidth, budgetY);
+
+    // Numbers: timings of the last completed frame, counters of this one
+    const FrameStats& last = count > 0 ? history[(head - 1 + HISTORY) % HISTORY] : current;
+    char line[128];
+    float y = textTop;
+    SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
+
+    std::snprintf(line, sizeof(line), "frame %5.2f ms  gc %4.2f%s", last.frameMs, last.gcMs, last.gcForced ? " (forced)" : "");
+    SDL_RenderDebugText(renderer, left + padding, y, line);
+    y += LINE_HEIGHT;
+
+    std::snprintf(line, sizeof(line), "upd %4.2f  rnd %4.2f  prs %4.2f", last.updateMs, last.renderMs, last.presentMs);
+    SDL_RenderDebugText(renderer, left + padding, y, line);
+    y += LINE_HEIGHT;
+
+    std::snprintf(line, sizeof(line), "draws %u  texts %u  events %u",
+                  current.drawCalls, current.textObjects, current.events);
+    SDL_RenderDebugText(renderer, left + padding, y, line);
+    y += LINE_HEIGHT;
+
+    std::snprintf(line, sizeof(line), "lua heap %.1f KB  fonts %zu",
+                  info.luaHeapBytes / 1024.0, info.fontInstances);
+    SDL_RenderDebugText(renderer, left + padding, y, line);
+    y += LINE_HEIGHT;
+
+    // Legend in the bar colours
+    const char* labels[4] = {"upd", "rnd", "prs", "gc"};
+    float x = left + padding;
+    for (int p = 0; p < 4; p++) {
+        const SDL_Color& c = BAR_COLORS[p];
+        SDL_SetRenderDrawColor(renderer, c.r, c.g, c.b, c.a);
+        SDL_RenderDebugText(renderer, x, y, labels[p]);
+        x += 40.0f;
+    }
+
+    SDL_SetRenderDrawBlendMode(renderer, previousBlend);
+}
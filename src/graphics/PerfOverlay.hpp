@@ -0,0 +1,50 @@
+#ifndef PERFOVERLAY_HPP
+#define PERFOVERLAY_HPP
+
+#include <SDL3/SDL.h>
+#include <cstddef>
+#include <vector>
+
+#include "../core/FrameStats.hpp"
+
+// On-device performance HUD (F3 or setPerfOverlay from Lua).
+//
+// Shows a stacked frame-time graph of the last HISTORY frames (update,
+// render, present, GC) and the current frame's counters. It is drawn straight
+// to the renderer after the scene, outside the compositor, so it never shows
+// up in damage tracking or in its own draw-call count. The graph is a handful
+// of batched SDL_RenderFillRects calls; text uses SDL's debug font.
+class PerfOverlay {
+public:
+    // Values that do not come from FrameStats
+    struct Info {
+        size_t luaHeapBytes = 0;
+        size_t fontInstances = 0;
+    };
+
+private:
+    static const int HISTORY = 120;
+    static const int BAR_WIDTH = 2;
+    static const int GRAPH_HEIGHT = 100;
+    static constexpr float PIXELS_PER_MS = 4.0f;
+
+    FrameStats history[HISTORY];
+    int head = 0;                    // Next slot to write
+    int count = 0;
+    bool visible = false;
+
+    std::vector<SDL_FRect> bars[4];  // update, render, present, GC
+
+public:
+    void setVisible(bool show) { visible = show; }
+    bool isVisible() const { return visible; }
+    void toggle() { visible = !visible; }
+
+    // Record a completed frame
+    void push(const FrameStats& stats);
+
+    // Draw the HUD; `current` holds this frame's counters so far
+    void draw(SDL_Renderer* renderer, const FrameStats& current, const Info& info);
+};
+
+#endif // PERFOVERLAY_HPP
@@ -0,0 +1,127 @@
+#include "RenderCache.hpp"
+
+RenderCache::~RenderCache() {
+    cleanup();
+}
+
+void RenderCache::init(SDL_Renderer* r) {
+    renderer = r;
+}
+
+SDL_Texture* RenderCache::acquire(uint64_t key, int width, int height, bool& contentValid) {
+    contentValid = false;
+    if (!isEnabled() || width <= 0 || height <= 0) return nullptr;
+
+    Entry& entry = entries[key];
+
+    // Resize means recreate
+    if (entry.texture && (entry.width != width || entry.height != height)) {
+        destroyEntry(entry);
+    }
+
+    if (!entry.texture) {
+        entry.texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888,
+                                          SDL_TEXTUREACCESS_TARGET, width, height);
+        if (!entry.texture) {
+            entries.erase(key);
+            return nullptr;
+        }
+        SDL_SetTextureBlendMode(entry.texture, SDL_BLENDMODE_BLEND);
+        SDL_SetTextureScaleMode(entry.texture, SDL_SCALEMODE_NEAREST);
+        entry.width = width;
+        entry.height = height;
+        entry.contentValid = false;
+        totalBytes += static_cast<size_t>(width) * height * 4;
+    }
+
+    entry.lastUsedFrame = currentFrame;
+    contentValid = entry.contentValid;
+    if (contentValid) {
+        stats.hits++;
+    }
+    return entry.texture;
+}
+
+void RenderCache::markValid(uint64_t key) {
+    auto it = entries.find(key);
+    if (it == entries.end()) return;
+    it->second.contentValid = true;
+    stats.redraws++;
+}
+
+void RenderCache::release(uint64_t key) {
+    auto it = entries.find(key);
+    if (it == entries.end()) return;
+    destroyEntry(it->second);
+    entries.erase(it);
+}
+
+void RenderCache::trim() {
+    // Drop textures of widgets that have not been drawn for a while
+    for (auto it = entries.begin(); it != entries.end();) {
+        if (currentFrame - it->second.lastUsedFrame > maxIdleFrames) {
+            destroyEntry(it->second);
+            it = entries.erase(it);
+            stats.evictions++;
+        } else {
+            ++it;
+        }
+    }
+
+    evictUntilWithinBudget();
+}
+
+void RenderCache::evictUntilWithinBudget() {
+    while (totalBytes > budgetBytes) {
+        // Least recently used entry that was not drawn this frame
+        auto victim = entries.end();
+        for (auto it = entries.begin(); it != entries.end(); ++it) {
+            if (it->second.lastUsedFrame == currentFrame) continue;
+            if (victim == entries.end() || it->second.lastUsedFrame < victim->second.lastUsedFrame) {
+                victim = it;
+            }
+        }
+        if (victim == entries.end()) break;  // Everything left is in use
+
+        destroyEntry(victim->second);
+        entries.erase(victim);
+        stats.evictions++;
+    }
+}
+
+void RenderCache::setBudget(size_t bytes) {
+    budgetBytes = bytes;
+    evictUntilWithinBudget();
+}
+
+void RenderCache::setEnabled(bool e) {
+    enabled = e;
+    if (!enabled) {
+        cleanup();
+    }
+}
+
+RenderCache::Stats RenderCache::getStats() const {
+    Stats result = stats;
+    result.entries = entries.size();
+    result.bytes = totalBytes;
+    result.budgetBytes = budgetBytes;
+    return result;
+}
+
+void RenderCache::destroyEntry(Entry& entry) {
+    if (entry.texture) {
+        SDL_DestroyTexture(entry.texture);
+        totalBytes -= static_cast<size_t>(entry.width) * entry.height * 4;
+        entry.texture = nullptr;
+    }
+    entry.contentValid = false;
+}
+
+void RenderCache::cleanup() {
+    for (auto& [key, entry] : entries) {
+        destroyEntry(entry);
+    }
+    entries.clear();
+    totalBytes = 0;
+}
@@ -0,0 +1,80 @@
+#ifndef RENDERCACHE_HPP
+#define RENDERCACHE_HPP
+
+#include <SDL3/SDL.h>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+
+// Cache of render-target textures holding pre-rendered widget content.
+// Entries are keyed by a widget cache key and tracked by the frame they were
+// last drawn in; the cache evicts least recently seen entries once the total
+// texture memory exceeds its budget, and drops entries unseen for a while.
+class RenderCache {
+public:
+    struct Stats {
+        size_t entries = 0;
+        size_t bytes = 0;
+        size_t budgetBytes = 0;
+        uint64_t hits = 0;        // Frames composited from a valid texture
+        uint64_t redraws = 0;     // Textures (re)rendered because content changed
+        uint64_t evictions = 0;
+    };
+
+private:
+    struct Entry {
+        SDL_Texture* texture = nullptr;
+        int width = 0;
+        int height = 0;
+        Uint64 lastUsedFrame = 0;
+        bool contentValid = false;
+    };
+
+    SDL_Renderer* renderer = nullptr;
+    std::unordered_map<uint64_t, Entry> entries;
+    size_t totalBytes = 0;
+    size_t budgetBytes = 32 * 1024 * 1024;
+    Uint64 maxIdleFrames = 600;   // ~10 seconds at 60 FPS
+    Uint64 currentFrame = 0;
+    bool enabled = true;
+    Stats stats;
+
+public:
+    RenderCache() = default;
+    ~RenderCache();
+
+    RenderCache(const RenderCache&) = delete;
+    RenderCache& operator=(const RenderCache&) = delete;
+
+    void init(SDL_Renderer* r);
+
+    // Get the texture for key at the given pixel size, creating or resizing it
+    // as needed. contentValid is false when the caller must redraw the texture.
+    // Returns nullptr when caching is disabled or the texture cannot be created.
+    SDL_Texture* acquire(uint64_t key, int width, int height, bool& contentValid);
+
+    // Mark the texture for key as holding up-to-date content
+    void markValid(uint64_t key);
+
+    // Drop the texture for key (e.g. when its widget is destroyed)
+    void release(uint64_t key);
+
+    // Frame bookkeeping: call beginFrame before drawing, trim after
+    void beginFrame(Uint64 frame) { currentFrame = frame; }
+    void trim();
+
+    void setBudget(size_t bytes);
+    void setEnabled(bool e);
+    bool isEnabled() const { return enabled && renderer != nullptr; }
+
+    Stats getStats() const;
+
+    // Destroy all textures
+    void cleanup();
+
+private:
+    void destroyEntry(Entry& entry);
+    void evictUntilWithinBudget();
+};
+
+#endif // RENDERCACHE_HPP
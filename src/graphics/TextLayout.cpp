@@ -0,0 +1,303 @@
+#include "TextLayout.hpp"
+#include "Compositor.hpp"
+#include <algorithm>
+#include <cstdio>
+
+namespace {
+
+// Scratch buffer for splitting strings into per-face runs
+std::vector<FontManager::TextRun> textRuns;
+
+// Length in bytes of the UTF-8 character starting at text[0]
+size_t utf8CharLength(const char* text, size_t length) {
+    const char* p = text;
+    size_t remaining = length;
+    SDL_StepUTF8(&p, &remaining);
+    return std::max<size_t>(1, static_cast<size_t>(p - text));
+}
+
+} // namespace
+
+bool measureTextRuns(FontManager& fonts, TTF_Font* primary, int fontId, float size,
+                     const char* text, size_t length, int& width, int& height) {
+    width = 0;
+    height = 0;
+    if (!primary) return false;
+
+    fonts.splitRuns(fontId, text, length, textRuns);
+    if (textRuns.size() <= 1) {
+        return TTF_GetStringSize(primary, text, length, &width, &height);
+    }
+
+    for (const auto& run : textRuns) {
+        TTF_Font* font = run.fontId == fontId ? primary : fonts.getFont(run.fontId, size);
+        int w = 0, h = 0;
+        if (font && TTF_GetStringSize(font, text + run.offset, run.length, &w, &h)) {
+            width += w;
+            height = std::max(height, h);
+        }
+    }
+    return true;
+}
+
+size_t fitTextRuns(FontManager& fonts, TTF_Font* primary, int fontId, float size,
+                   const char* text, size_t length, int maxWidth, int& width) {
+    width = 0;
+    if (!primary || length == 0 || maxWidth <= 0) return 0;
+
+    fonts.splitRuns(fontId, text, length, textRuns);
+    size_t fitted = 0;
+    for (const auto& run : textRuns) {
+        // A max width of 0 means unbounded to SDL_ttf, so stop when it is used up
+        int available = maxWidth - width;
+        if (available <= 0) break;
+
+        TTF_Font* font = run.fontId == fontId ? primary : fonts.getFont(run.fontId, size);
+        int w = 0;
+        size_t measured = 0;
+        if (!font || !TTF_MeasureString(font, text + run.offset, run.length, available, &w, &measured)) break;
+
+        width += w;
+        fitted = run.offset + measured;
+        if (measured < run.length) break;
+    }
+    return fitted;
+}
+
+void drawTextRuns(FontManager& fonts, Compositor& compositor, TTF_Font* primary, int fontId, float size,
+                  std::string_view text, float x, float y, SDL_Color color) {
+    if (!primary) return;
+
+    fonts.splitRuns(fontId, text.data(), text.size(), textRuns);
+    if (textRuns.size() <= 1) {
+        compositor.text(primary, text, x, y, color);
+        return;
+    }
+
+    int ascent = TTF_GetFontAscent(primary);
+    for (const auto& run : textRuns) {
+        TTF_Font* font = run.fontId == fontId ? primary : fonts.getFont(run.fontId, size);
+        if (!font) continue;
+        float baseline = static_cast<float>(ascent - TTF_GetFontAscent(font));
+        compositor.text(font, text.substr(run.offset, run.length), x, y + baseline, color);
+
+        int w = 0, h = 0;
+        TTF_GetStringSize(font, text.data() + run.offset, run.length, &w, &h);
+        x += w;
+    }
+}
+
+bool TextMeasureCache::measure(FontManager& fonts, TTF_Font* primary, int fontId, float size,
+                               const char* text, size_t length, int& width, int& height) {
+    width = 0;
+    height = 0;
+    if (!primary) return false;
+
+    // Key: font ID and quantised size as raw bytes, then the text
+    float quantised = fonts.quantiseSize(size);
+    key.assign(reinterpret_cast<const char*>(&fontId), sizeof(fontId));
+    key.append(reinterpret_cast<const char*>(&quantised), sizeof(quantised));
+    key.append(text, length);
+
+    auto it = entries.find(key);
+    if (it != entries.end()) {
+        width = it->second.width;
+        height = it->second.height;
+        stats.hits++;
+        return true;
+    }
+
+    if (!measureTextRuns(fonts, primary, fontId, size, text, length, width, height)) return false;
+    stats.misses++;
+    if (entries.size() >= capacity) {
+        entries.clear();
+    }
+    entries.emplace(key, Size{width, height});
+    return true;
+}
+
+void TextMeasureCache::setCapacity(size_t maxEntries) {
+    capacity = std::max<size_t>(1, maxEntries);
+    if (entries.size() > capacity) {
+        entries.clear();
+    }
+}
+
+TextMeasureCache::Stats TextMeasureCache::getStats() const {
+    Stats result = stats;
+    result.entries = entries.size();
+    return result;
+}
+
+void TextLayout::draw(FontManager& fonts, Compositor& compositor, float x, float y, SDL_Color color) const {
+    TTF_Font* font = fonts.getFont(fontId, fontSize);
+    if (!font) return;  // Font was closed
+    for (const Line& line : lines) {
+        drawTextRuns(fonts, compositor, font, fontId, fontSize, line.text, x + line.x, y + line.y, color);
+    }
+}
+
+std::shared_ptr<TextLayout> TextLayoutCache::get(FontManager& fonts, int fontId, float size,
+                                                 const std::string& text, const TextLayoutParams& params) {
+    TTF_Font* font = fonts.getFont(fontId, size);
+    if (!font) return nullptr;
+
+    char prefix[160];
+    std::snprintf(prefix, sizeof(prefix), "%d|%a|%a|%d|%d|%d|%d|%a|",
+                  fontId, fonts.quantiseSize(size), params.width, static_cast<int>(params.align),
+                  params.wrap, params.ellipsis, params.maxLines, params.lineSpacing);
+    std::string key = prefix + text;
+
+    auto it = index.find(key);
+    if (it != index.end()) {
+        lru.splice(lru.begin(), lru, it->second);
+        stats.hits++;
+        return it->second->second;
+    }
+
+    std::shared_ptr<TextLayout> layout = build(fonts, font, fontId, size, text, params);
+    stats.misses++;
+    lru.emplace_front(std::move(key), layout);
+    index[lru.front().first] = lru.begin();
+    while (lru.size() > capacity) {
+        index.erase(lru.back().first);
+        lru.pop_back();
+    }
+    return layout;
+}
+
+void TextLayoutCache::setCapacity(size_t entries) {
+    capacity = std::max<size_t>(1, entries);
+    while (lru.size() > capacity) {
+        index.erase(lru.back().first);
+        lru.pop_back();
+    }
+}
+
+void TextLayoutCache::clear() {
+    index.clear();
+    lru.clear();
+}
+
+TextLayoutCache::Stats TextLayoutCache::getStats() const {
+    Stats result = stats;
+    result.entries = lru.size();
+    return result;
+}
+
+std::shared_ptr<TextLayout> TextLayoutCache::build(FontManager& fonts, TTF_Font* font, int fontId, float size,
+                                                   const std::string& text, const TextLayoutParams& params) {
+    auto layout = std::make_shared<TextLayout>();
+    layout->fontId = fontId;
+    layout->fontSize = size;
+
+    const bool bounded = params.width > 0.0f;
+    const int maxWidth = static_cast<int>(params.width);
+    const float lineSkip = TTF_GetFontLineSkip(font) * params.lineSpacing;
+    bool truncated = false;
+
+    auto addLine = [&](size_t begin, size_t end) -> bool {
+        if (params.maxLines > 0 && static_cast<int>(layout->lines.size()) >= params.maxLines) {
+            truncated = true;
+            return false;
+        }
+        layout->lines.push_back(TextLayout::Line{text.substr(begin, end - begin), begin, 0.0f, 0.0f, 0.0f});
+        return true;
+    };
+
+    // Break paragraphs into lines
+    size_t start = 0;
+    while (!truncated) {
+        size_t newline = text.find('\n', start);
+        size_t end = newline == std::string::npos ? text.size() : newline;
+
+        if (!bounded || !params.wrap) {
+            addLine(start, end);
+        } else {
+            size_t pos = start;
+            do {
+                // Continuation lines do not start with the space they broke at
+                if (pos > start) {
+                    while (pos < end && text[pos] == ' ') pos++;
+                    if (pos == end) break;
+                }
+
+                int fittedWidth = 0;
+                size_t fit = fitTextRuns(fonts, font, fontId, size, text.data() + pos, end - pos, maxWidth, fittedWidth);
+                if (pos + fit >= end) {
+                    addLine(pos, end);
+                    break;
+                }
+
+                // Prefer breaking at the last space that still fits
+                size_t lineEnd, next;
+                size_t space = text.find_last_of(' ', pos + fit);
+                if (space != std::string::npos && space > pos) {
+                    lineEnd = space;
+                    next = space + 1;
+                } else {
+                    // One long word: break inside it, at least one character per line
+                    lineEnd = pos + (fit > 0 ? fit : utf8CharLength(text.data() + pos, end - pos));
+                    next = lineEnd;
+                }
+                if (!addLine(pos, lineEnd)) break;
+                pos = next;
+            } while (pos < end);
+        }
+
+        if (newline == std::string::npos) break;
+        start = newline + 1;
+    }
+
+    // Ellipsis: overlong unwrapped lines, and the last line when lines were cut
+    if (params.ellipsis && !layout->lines.empty()) {
+        const char* ellipsis = fonts.hasGlyph(fontId, 0x2026) ? "\xE2\x80\xA6" : "...";
+        int ellipsisWidth = 0, ellipsisHeight = 0;
+        measureTextRuns(fonts, font, fontId, size, ellipsis, SDL_strlen(ellipsis), ellipsisWidth, ellipsisHeight);
+
+        for (size_t i = 0; i < layout->lines.size(); i++) {
+            std::string& lineText = layout->lines[i].text;
+            int w = 0, h = 0;
+            measureTextRuns(fonts, font, fontId, size, lineText.data(), lineText.size(), w, h);
+            bool cut = truncated && i + 1 == layout->lines.size();
+            if (!cut && (!bounded || w <= maxWidth)) continue;
+
+            if (bounded) {
+                int fittedWidth = 0;
+                size_t fit = fitTextRuns(fonts, font, fontId, size, lineText.data(), lineText.size(),
+                                         std::max(1, maxWidth - ellipsisWidth), fittedWidth);
+                lineText.resize(fit);
+            }
+            while (!lineText.empty() && lineText.back() == ' ') {
+                lineText.pop_back();
+            }
+            lineText += ellipsis;
+        }
+    }
+
+    // Measure and align
+    float widest = 0.0f;
+    for (TextLayout::Line& line : layout->lines) {
+        int w = 0, h = 0;
+        measureTextRuns(fonts, font, fontId, size, line.text.data(), line.text.size(), w, h);
+        line.width = static_cast<float>(w);
+        widest = std::max(widest, line.width);
+    }
+
+    float boxWidth = bounded ? params.width : widest;
+    float y = 0.0f;
+    for (TextLayout::Line& line : layout->lines) {
+        switch (params.align) {
+        case TextAlign::Left:   line.x = 0.0f; break;
+        case TextAlign::Center: line.x = (boxWidth - line.width) / 2.0f; break;
+        case TextAlign::Right:  line.x = boxWidth - line.width; break;
+        }
+        line.y = y;
+        y += lineSkip;
+    }
+
+    layout->width = widest;
+    layout->height = layout->lines.empty() ? 0.0f
+                   : (layout->lines.size() - 1) * lineSkip + TTF_GetFontHeight(font);
+    return layout;
+}
@@ -0,0 +1,133 @@
+#ifndef TEXTLAYOUT_HPP
+#define TEXTLAYOUT_HPP
+
+#include <SDL3/SDL.h>
+#include <SDL3_ttf/SDL_ttf.h>
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "FontManager.hpp"
+
+// Forward declaration
+class Compositor;
+
+// Run-aware text helpers: strings are split into runs per fallback face (see
+// FontManager::splitRuns) and each run is measured/drawn with its own font.
+
+// Measure text; width is the sum of the runs, height the tallest run
+bool measureTextRuns(FontManager& fonts, TTF_Font* primary, int fontId, float size,
+                     const char* text, size_t length, int& width, int& height);
+
+// Number of bytes of text that fit in maxWidth pixels (whole characters only)
+size_t fitTextRuns(FontManager& fonts, TTF_Font* primary, int fontId, float size,
+                   const char* text, size_t length, int maxWidth, int& width);
+
+// Draw text as per-face runs on a shared baseline
+void drawTextRuns(FontManager& fonts, Compositor& compositor, TTF_Font* primary, int fontId, float size,
+                  std::string_view text, float x, float y, SDL_Color color);
+
+// Bounded cache of measured string sizes keyed by (font, size, text). Used by
+// measureText and the bulk measuring APIs; when it fills up it starts over.
+class TextMeasureCache {
+public:
+    struct Stats {
+        size_t entries = 0;
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+    };
+
+private:
+    struct Size {
+        int width;
+        int height;
+    };
+
+    std::unordered_map<std::string, Size> entries;
+    std::string key;           // Reused lookup key (no allocation on hits)
+    size_t capacity = 16384;
+    Stats stats;
+
+public:
+    bool measure(FontManager& fonts, TTF_Font* primary, int fontId, float size,
+                 const char* text, size_t length, int& width, int& height);
+
+    void setCapacity(size_t maxEntries);
+    void clear() { entries.clear(); }
+    Stats getStats() const;
+};
+
+enum class TextAlign { Left, Center, Right };
+
+struct TextLayoutParams {
+    float width = 0.0f;        // Box width; <= 0 means unbounded (no wrap/ellipsis)
+    TextAlign align = TextAlign::Left;
+    bool wrap = true;          // Break lines at spaces to fit the width
+    bool ellipsis = false;     // Shorten overlong (or the last allowed) lines with "…"
+    int maxLines = 0;          // 0 = unlimited
+    float lineSpacing = 1.0f;  // Multiplier on the font's line skip
+};
+
+// Laid out paragraph: lines with their alignment offsets, ready to draw
+class TextLayout {
+public:
+    struct Line {
+        std::string text;      // Line contents (ellipsis included)
+        size_t sourceOffset;   // Byte offset of the line start in the source text
+        float x;               // Alignment offset inside the box
+        float y;
+        float width;
+    };
+
+    int fontId = 0;
+    float fontSize = 0.0f;
+    float width = 0.0f;        // Widest line (lines are aligned within the box width)
+    float height = 0.0f;
+    std::vector<Line> lines;
+
+    // Draw every line at (x, y) + line offsets through the compositor
+    void draw(FontManager& fonts, Compositor& compositor, float x, float y, SDL_Color color) const;
+};
+
+// Cache of laid out paragraphs keyed by (font, size, text, params). Repeated
+// requests return the same layout, so drawing a paragraph every frame costs
+// no measuring at all; the least recently requested layouts are dropped once
+// the cache is full.
+class TextLayoutCache {
+public:
+    struct Stats {
+        size_t entries = 0;
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+    };
+
+private:
+    using Entry = std::pair<std::string, std::shared_ptr<TextLayout>>;
+
+    std::list<Entry> lru;      // Most recently used first
+    std::unordered_map<std::string, std::list<Entry>::iterator> index;
+    size_t capacity = 256;
+    Stats stats;
+
+public:
+    // Lay out text with a font (at a size) or return the cached layout
+    std::shared_ptr<TextLayout> get(FontManager& fonts, int fontId, float size,
+                                    const std::string& text, const TextLayoutParams& params);
+
+    void setCapacity(size_t entries);
+
+    // Drop everything (fonts or fallback chains changed)
+    void clear();
+
+    Stats getStats() const;
+
+private:
+    static std::shared_ptr<TextLayout> build(FontManager& fonts, TTF_Font* font, int fontId, float size,
+                                             const std::string& text, const TextLayoutParams& params);
+};
+
+#endif // TEXTLAYOUT_HPP
@@ -0,0 +1,184 @@
+#include "LayoutNode.hpp"
+#include "../widgets/TextWidget.hpp"
+#include <algorithm>
+
+LayoutNode::~LayoutNode() {
+    for (auto& child : children) {
+        child->parent = nullptr;
+    }
+}
+
+bool LayoutNode::isAncestorOf(const LayoutNode* node) const {
+    for (const LayoutNode* p = node; p; p = p->parent) {
+        if (p == this) return true;
+    }
+    return false;
+}
+
+bool LayoutNode::addChild(const std::shared_ptr<LayoutNode>& child) {
+    // Refuse to create cycles (adding an ancestor or the node itself)
+    if (!child || child->isAncestorOf(this)) return false;
+
+    if (child->parent) {
+        child->parent->removeChild(child);
+    }
+    child->parent = this;
+    children.push_back(child);
+    child->dirty = true;
+    markDirty();
+    return true;
+}
+
+void LayoutNode::removeChild(const std::shared_ptr<LayoutNode>& child) {
+    auto it = std::find(children.begin(), children.end(), child);
+    if (it == children.end()) return;
+
+    (*it)->parent = nullptr;
+    children.erase(it);
+    markDirty();
+}
+
+void LayoutNode::clearChildren() {
+    if (children.empty()) return;
+    for (auto& child : children) {
+        child->parent = nullptr;
+    }
+    children.clear();
+    markDirty();
+}
+
+void LayoutNode::setDirection(Direction d) {
+    if (direction == d) return;
+    direction = d;
+    markDirty();
+}
+
+void LayoutNode::setPadding(float left, float top, float right, float bottom) {
+    if (paddingLeft == left && paddingTop == top && paddingRight == right && paddingBottom == bottom) return;
+    paddingLeft = left;
+    paddingTop = top;
+    paddingRight = right;
+    paddingBottom = bottom;
+    markDirty();
+}
+
+void LayoutNode::setGap(float g) {
+    if (gap == g) return;
+    gap = g;
+    markDirty();
+}
+
+// Sizing properties change how the parent distributes space, so the parent
+// (and thereby its ancestors) is invalidated along with this node
+void LayoutNode::setFlex(float f) {
+    if (flex == f) return;
+    flex = f;
+    markDirty();
+}
+
+void LayoutNode::setFixedSize(float w, float h) {
+    if (fixedWidth == w && fixedHeight == h) return;
+    fixedWidth = w;
+    fixedHeight = h;
+    markDirty();
+}
+
+void LayoutNode::setWidget(SlotHandle handle) {
+    if (widget == handle) return;
+    widget = handle;
+    markDirty();
+}
+
+void LayoutNode::markDirty() {
+    // Ancestors of a dirty node are always dirty, so propagation can stop early
+    for (LayoutNode* node = this; node && !node->dirty; node = node->parent) {
+        node->dirty = true;
+    }
+}
+
+void LayoutNode::layout(const SDL_FRect& bounds, SlotMap<TextWidget>& widgets) {
+    bool moved = bounds.x != rect.x || bounds.y != rect.y ||
+                 bounds.w != rect.w || bounds.h != rect.h;
+    if (!dirty && !moved) return;
+
+    rect = bounds;
+    dirty = false;
+
+    if (TextWidget* w = widgets.get(widget)) {
+        w->setPosition(rect.x, rect.y);
+        w->setSize(rect.w, rect.h);
+    }
+
+    if (children.empty()) return;
+
+    SDL_FRect content = {
+        rect.x + paddingLeft,
+        rect.y + paddingTop,
+        std::max(0.0f, rect.w - paddingLeft - paddingRight),
+        std::max(0.0f, rect.h - paddingTop - paddingBottom)
+    };
+
+    switch (direction) {
+        case Direction::Row:
+            layoutLinear(content, true, widgets);
+            break;
+        case Direction::Column:
+            layoutLinear(content, false, widgets);
+            break;
+        case Direction::Stack:
+            layoutStack(content, widgets);
+            break;
+    }
+}
+
+void LayoutNode::layoutLinear(const SDL_FRect& content, bool horizontal, SlotMap<TextWidget>& widgets) {
+    float mainSize = horizontal ? content.w : content.h;
+    float crossSize = horizontal ? content.h : content.w;
+
+    // First pass: fixed sizes and total flex weight
+    float fixedTotal = 0.0f;
+    float flexTotal = 0.0f;
+    for (auto& child : children) {
+        float fixedMain = horizontal ? child->fixedWidth : child->fixedHeight;
+        if (fixedMain >= 0) {
+            fixedTotal += fixedMain;
+        } else {
+            flexTotal += std::max(0.0f, child->flex);
+        }
+    }
+
+    float gaps = gap * static_cast<float>(children.size() - 1);
+    float remaining = std::max(0.0f, mainSize - fixedTotal - gaps);
+
+    // Second pass: assign rectangles along the main axis
+    float cursor = horizontal ? content.x : content.y;
+    for (auto& child : children) {
+        float fixedMain = horizontal ? child->fixedWidth : child->fixedHeight;
+        float fixedCross = horizontal ? child->fixedHeight : child->fixedWidth;
+
+        float main = fixedMain;
+        if (main < 0) {
+            main = flexTotal > 0 ? remaining * std::max(0.0f, child->flex) / flexTotal : 0.0f;
+        }
+        float cross = fixedCross >= 0 ? std::min(fixedCross, crossSize) : crossSize;
+
+        SDL_FRect childRect = horizontal
+            ? SDL_FRect{cursor, content.y, main, cross}
+            : SDL_FRect{content.x, cursor, cross, main};
+        child->layout(childRect, widgets);
+
+        cursor += main + gap;
+    }
+}
+
+void LayoutNode::layoutStack(const SDL_FRect& content, SlotMap<TextWidget>& widgets) {
+    for (auto& child : children) {
+        SDL_FRect childRect = {
+            content.x,
+            content.y,
+            child->fixedWidth >= 0 ? std::min(child->fixedWidth, content.w) : content.w,
+            child->fixedHeight >= 0 ? std::min(child->fixedHeight, content.h) : content.h
+        };
+        child->layout(childRect, widgets);
+    }
+}
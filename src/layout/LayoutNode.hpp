@@ -0,0 +1,91 @@
+#ifndef LAYOUTNODE_HPP
+#define LAYOUTNODE_HPP
+
+#include <SDL3/SDL.h>
+#include <memory>
+#include <vector>
+
+#include "../core/SlotMap.hpp"
+
+// Forward declaration
+class TextWidget;
+
+// Retained layout container (row / column / stack) with flex weights.
+// Computed rectangles are cached; a node only recomputes its children when it
+// was marked dirty or the rectangle handed to it by its parent changed, so an
+// unchanged tree costs a single comparison per frame.
+class LayoutNode {
+public:
+    enum class Direction {
+        Row,     // Children side by side, left to right
+        Column,  // Children stacked top to bottom
+        Stack    // Children overlap, each filling the content area
+    };
+
+private:
+    Direction direction = Direction::Column;
+    float paddingLeft = 0, paddingTop = 0, paddingRight = 0, paddingBottom = 0;
+    float gap = 0;
+
+    // Sizing inside the parent: a fixed size (< 0 means unset) on either axis,
+    // otherwise the node takes a flex share of the main axis and stretches
+    // across the cross axis
+    float fixedWidth = -1.0f;
+    float fixedHeight = -1.0f;
+    float flex = 1.0f;
+
+    // Widget positioned by this node (invalid handle for pure containers)
+    SlotHandle widget;
+
+    LayoutNode* parent = nullptr;
+    std::vector<std::shared_ptr<LayoutNode>> children;
+
+    SDL_FRect rect = {0, 0, -1, -1};  // Cached result (negative size: never laid out)
+    bool dirty = true;
+
+public:
+    LayoutNode() = default;
+    ~LayoutNode();
+
+    LayoutNode(const LayoutNode&) = delete;
+    LayoutNode& operator=(const LayoutNode&) = delete;
+
+    // Tree structure (adding a node detaches it from its previous parent)
+    bool addChild(const std::shared_ptr<LayoutNode>& child);
+    void removeChild(const std::shared_ptr<LayoutNode>& child);
+    void clearChildren();
+    size_t getChildCount() const { return children.size(); }
+
+    // Properties (each marks the affected subtree dirty when it changes)
+    void setDirection(Direction d);
+    void setPadding(float left, float top, float right, float bottom);
+    void setGap(float g);
+    void setFlex(float f);
+    void setFixedSize(float w, float h);
+    void setWidget(SlotHandle handle);
+
+    Direction getDirection() const { return direction; }
+    float getFlex() const { return flex; }
+    float getFixedWidth() const { return fixedWidth; }
+    float getFixedHeight() const { return fixedHeight; }
+    SDL_FRect getPadding() const { return {paddingLeft, paddingTop, paddingRight, paddingBottom}; }  // left, top, right, bottom
+    SlotHandle getWidget() const { return widget; }
+
+    // Last computed rectangle
+    const SDL_FRect& getRect() const { return rect; }
+
+    // Mark this node for re-layout; propagates up so the root notices
+    void markDirty();
+    bool isDirty() const { return dirty; }
+
+    // Lay out this subtree inside bounds and apply results to widgets.
+    // Returns immediately when nothing changed since the previous call.
+    void layout(const SDL_FRect& bounds, SlotMap<TextWidget>& widgets);
+
+private:
+    void layoutLinear(const SDL_FRect& content, bool horizontal, SlotMap<TextWidget>& widgets);
+    void layoutStack(const SDL_FRect& content, SlotMap<TextWidget>& widgets);
+    bool isAncestorOf(const LayoutNode* node) const;
+};
+
+#endif // LAYOUTNODE_HPP
@@ -0,0 +1,98 @@
+#include "AllocationTracker.hpp"
+
+void AllocationTracker::setBindingNames(std::vector<std::string> bindingNames) {
+    names.clear();
+    names.push_back("(script)");
+    for (auto& name : bindingNames) {
+        names.push_back(std::move(name));
+    }
+    current.assign(names.size(), Counts{});
+    previous.assign(names.size(), Counts{});
+}
+
+void AllocationTracker::enable(lua_State* state) {
+    if (enabled || !state) return;
+    L = state;
+    enabled = true;
+
+    baseAlloc = lua_getallocf(L, &baseUserData);
+    lua_setallocf(L, &AllocationTracker::countingAlloc, this);
+
+    // Wrap each binding: upvalues are the original function, its index and us
+    originalRefs.assign(names.size(), LUA_NOREF);
+    for (size_t i = 1; i < names.size(); i++) {
+        lua_getglobal(L, names[i].c_str());
+        if (!lua_iscfunction(L, -1)) {
+            lua_pop(L, 1);
+            continue;
+        }
+        lua_pushvalue(L, -1);
+        originalRefs[i] = luaL_ref(L, LUA_REGISTRYINDEX);
+        lua_pushinteger(L, static_cast<lua_Integer>(i));
+        lua_pushlightuserdata(L, this);
+        lua_pushcclosure(L, &AllocationTracker::trackedCall, 3);
+        lua_setglobal(L, names[i].c_str());
+    }
+}
+
+void AllocationTracker::disable() {
+    if (!enabled) return;
+
+    for (size_t i = 1; i < originalRefs.size(); i++) {
+        if (originalRefs[i] == LUA_NOREF) continue;
+        lua_rawgeti(L, LUA_REGISTRYINDEX, originalRefs[i]);
+        lua_setglobal(L, names[i].c_str());
+        luaL_unref(L, LUA_REGISTRYINDEX, originalRefs[i]);
+    }
+    originalRefs.clear();
+
+    lua_setallocf(L, baseAlloc, baseUserData);
+    enabled = false;
+    currentBinding = 0;
+}
+
+void AllocationTracker::beginFrame() {
+    if (!enabled) return;
+    previous.swap(current);
+    current.assign(names.size(), Counts{});
+}
+
+std::vector<std::pair<std::string, AllocationTracker::Counts>> AllocationTracker::lastFrame() const {
+    std::vector<std::pair<std::string, Counts>> result;
+    for (size_t i = 0; i < previous.size(); i++) {
+        if (previous[i].allocations > 0) {
+            result.emplace_back(names[i], previous[i]);
+        }
+    }
+    return result;
+}
+
+void* AllocationTracker::countingAlloc(void* ud, void* ptr, size_t osize, size_t nsize) {
+    auto* self = static_cast<AllocationTracker*>(ud);
+    // New blocks and growing reallocations count; frees and shrinks do not
+    if (nsize > 0 && (!ptr || nsize > osize) && self->currentBinding < static_cast<int>(self->current.size())) {
+        Counts& counts = self->current[self->currentBinding];
+        counts.allocations++;
+        counts.bytes += ptr ? nsize - osize : nsize;
+    }
+    return self->baseAlloc(self->baseUserData, ptr, osize, nsize);
+}
+
+int AllocationTracker::trackedCall(lua_State* L) {
+    auto* self = static_cast<AllocationTracker*>(lua_touserdata(L, lua_upvalueindex(3)));
+    int binding = static_cast<int>(lua_tointeger(L, lua_upvalueindex(2)));
+
+    int nargs = lua_gettop(L);
+    lua_pushvalue(L, lua_upvalueindex(1));
+    lua_insert(L, 1);
+
+    int previousBinding = self->currentBinding;
+    self->currentBinding = binding;
+    int status = lua_pcall(L, nargs, LUA_MULTRET, 0);
+    self->currentBinding = previousBinding;
+
+    if (status != 0) {
+        return lua_error(L);  // Re-raise with the original message
+    }
+    return lua_gettop(L);
+}
@@ -0,0 +1,60 @@
+#ifndef ALLOCATIONTRACKER_HPP
+#define ALLOCATIONTRACKER_HPP
+
+#include <sol/sol.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Debug aid: counts Lua heap allocations per global binding per frame.
+//
+// When enabled, the state's allocator is wrapped with a counting pass-through
+// and every global C function registered by LuaBindings is replaced by a
+// small C closure that marks the binding as current while it runs. Anything
+// allocated outside a binding is attributed to "(script)". Disabling restores
+// the original functions and allocator.
+class AllocationTracker {
+public:
+    struct Counts {
+        uint64_t allocations = 0;
+        uint64_t bytes = 0;
+    };
+
+private:
+    lua_State* L = nullptr;
+    lua_Alloc baseAlloc = nullptr;
+    void* baseUserData = nullptr;
+    bool enabled = false;
+
+    std::vector<std::string> names;        // Index 0 is "(script)"
+    std::vector<Counts> current;
+    std::vector<Counts> previous;          // Last completed frame
+    std::vector<int> originalRefs;         // Registry refs to unwrapped functions
+    int currentBinding = 0;
+
+public:
+    AllocationTracker() = default;
+
+    AllocationTracker(const AllocationTracker&) = delete;
+    AllocationTracker& operator=(const AllocationTracker&) = delete;
+
+    // Global names to attribute (the bindings registered by LuaBindings)
+    void setBindingNames(std::vector<std::string> bindingNames);
+
+    // state: the main thread (kept until disable, which runs at exit)
+    void enable(lua_State* state);
+    void disable();
+    bool isEnabled() const { return enabled; }
+
+    // Start a new frame: the counts gathered so far become the last frame's
+    void beginFrame();
+
+    // Name and counts of every binding that allocated in the last frame
+    std::vector<std::pair<std::string, Counts>> lastFrame() const;
+
+private:
+    static void* countingAlloc(void* ud, void* ptr, size_t osize, size_t nsize);
+    static int trackedCall(lua_State* L);
+};
+
+#endif // ALLOCATIONTRACKER_HPP
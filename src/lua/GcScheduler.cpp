@@ -0,0 +1,104 @@
+#include "GcScheduler.hpp"
+#include "LuaAllocator.hpp"
+#include "../core/Trace.hpp"
+#include <SDL3/SDL.h>
+#include <algorithm>
+
+void GcScheduler::attach(lua_State* state, const LuaAllocator* alloc) {
+    L = state;
+    allocator = alloc;
+    baselineBytes = heapBytes();
+    // LUA_GCSETPAUSE returns the previous value: read it back unchanged
+    defaultPause = lua_gc(L, LUA_GCSETPAUSE, 200);
+    lua_gc(L, LUA_GCSETPAUSE, defaultPause);
+    setBudget(budgetMs);
+}
+
+void GcScheduler::setBudget(double ms) {
+    budgetMs = std::max(0.0, ms);
+    enabled = budgetMs > 0.0;
+    if (!L) return;
+    if (enabled) {
+        armBackstop();
+    } else {
+        lua_gc(L, LUA_GCSETPAUSE, defaultPause);
+        lua_gc(L, LUA_GCRESTART, -1);
+    }
+}
+
+void GcScheduler::setThresholds(double pauseRatio, double forceHeapRatio) {
+    pause = std::max(1.0, pauseRatio);
+    forceRatio = std::max(pause, forceHeapRatio);
+    if (L && enabled) armBackstop();
+}
+
+void GcScheduler::armBackstop() {
+    // Lua's own trigger stays on, but only fires once the heap grows by
+    // forceRatio within a frame (or nears the allocator's cap), so a burst of
+    // garbage in one callback is still collected before run() sees it
+    size_t heap = std::max<size_t>(heapBytes(), 1);
+    double ratio = forceRatio;
+    if (allocator && allocator->getLimit() > 0) {
+        ratio = std::min(ratio, allocator->getLimit() / 4.0 * 3.0 / heap);
+    }
+    lua_gc(L, LUA_GCSETPAUSE, std::max(100, static_cast<int>(ratio * 100.0)));
+    // -1 (LuaJIT): threshold = heap * pause rather than an immediate cycle
+    lua_gc(L, LUA_GCRESTART, -1);
+}
+
+GcScheduler::Result GcScheduler::run(double slackMs) {
+    Result result;
+    if (!L || !enabled) return result;
+
+    size_t heap = heapBytes();
+    size_t baseline = std::max(baselineBytes, MIN_BASELINE);
+    size_t forceAt = static_cast<size_t>(baseline * forceRatio);
+    if (allocator && allocator->getLimit() > 0) {
+        forceAt = std::min(forceAt, allocator->getLimit() / 4 * 3);
+    }
+
+    result.forced = heap >= forceAt;
+    if (!collecting && !result.forced && heap < static_cast<size_t>(baseline * pause)) {
+        return result;
+    }
+
+    double budget = result.forced ? budgetMs * 4.0 : std::min(budgetMs, slackMs);
+    if (budget <= 0.0) return result;
+
+    TRACE_ZONE("Lua GC");
+
+    // Each LUA_GCSTEP re-arms the automatic trigger, so push it back after
+    Uint64 start = SDL_GetTicksNS();
+    Uint64 deadline = start + static_cast<Uint64>(budget * 1e6);
+    collecting = true;
+    do {
+        result.steps++;
+        if (lua_gc(L, LUA_GCSTEP, 0)) {
+            collecting = false;
+            cycles++;
+            baselineBytes = heapBytes();
+            break;
+        }
+    } while (SDL_GetTicksNS() < deadline);
+    armBackstop();
+
+    if (result.forced) forcedFrames++;
+    result.gcMs = (SDL_GetTicksNS() - start) / 1e6;
+    return result;
+}
+
+GcScheduler::Stats GcScheduler::getStats() const {
+    Stats stats;
+    stats.enabled = enabled;
+    stats.budgetMs = budgetMs;
+    stats.heapBytes = heapBytes();
+    stats.baselineBytes = baselineBytes;
+    stats.cycles = cycles;
+    stats.forcedFrames = forcedFrames;
+    return stats;
+}
+
+size_t GcScheduler::heapBytes() const {
+    if (!L) return 0;
+    return static_cast<size_t>(lua_gc(L, LUA_GCCOUNT, 0)) * 1024 + lua_gc(L, LUA_GCCOUNTB, 0);
+}
@@ -0,0 +1,72 @@
+#ifndef GCSCHEDULER_HPP
+#define GCSCHEDULER_HPP
+
+#include <sol/sol.hpp>
+#include <cstddef>
+#include <cstdint>
+
+// Forward declaration
+class LuaAllocator;
+
+// Paces the Lua garbage collector from the frame loop instead of letting
+// allocations trigger it mid-frame.
+//
+// The collector is advanced with LUA_GCSTEP in the time left after a frame
+// is presented, up to a per-frame budget. Lua's automatic trigger is kept as
+// a backstop, set to fire only when the heap grows by forceRatio between two
+// runs (or nears the allocator's cap). A cycle starts once
+// the heap has grown by `pause` over what the last cycle left alive. If the
+// heap still outgrows that (no slack for several frames, or a burst of
+// garbage) past `forceRatio`, or gets close to the allocator's cap, steps
+// run regardless of slack with a larger budget.
+class GcScheduler {
+public:
+    struct Result {
+        double gcMs = 0.0;
+        uint32_t steps = 0;
+        bool forced = false;
+    };
+
+    struct Stats {
+        bool enabled = false;
+        double budgetMs = 0.0;
+        size_t heapBytes = 0;
+        size_t baselineBytes = 0;    // Alive after the last completed cycle
+        uint64_t cycles = 0;
+        uint64_t forcedFrames = 0;
+    };
+
+private:
+    lua_State* L = nullptr;
+    const LuaAllocator* allocator = nullptr;
+    bool enabled = false;
+    bool collecting = false;         // A cycle is in progress
+    double budgetMs = 2.0;
+    double pause = 1.5;
+    double forceRatio = 3.0;
+    size_t baselineBytes = 0;
+    int defaultPause = 200;          // Lua's pause (%), restored when disabled
+    uint64_t cycles = 0;
+    uint64_t forcedFrames = 0;
+
+    static const size_t MIN_BASELINE = 256 * 1024;
+
+public:
+    // Take over GC pacing for a state (allocator: optional, for its cap)
+    void attach(lua_State* state, const LuaAllocator* alloc);
+
+    // Budget per frame in ms; 0 hands the collector back to Lua
+    void setBudget(double ms);
+    void setThresholds(double pauseRatio, double forceHeapRatio);
+
+    // Run GC steps for this frame with `slackMs` left before the next one
+    Result run(double slackMs);
+
+    Stats getStats() const;
+
+private:
+    size_t heapBytes() const;
+    void armBackstop();
+};
+
+#endif // GCSCHEDULER_HPP
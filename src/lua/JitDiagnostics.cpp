@@ -0,0 +1,181 @@
+#include "JitDiagnostics.hpp"
+#include "../core/Log.hpp"
+#include <algorithm>
+#include <cstdio>
+
+namespace {
+
+// Returns setup(record, bindingNames) -> toggle(on). Abort reasons are
+// formatted with jit.vmdef when it is installed, otherwise left as codes.
+const char* ATTACH_SCRIPT = R"(
+    return function(record, bindingNames)
+        local jit = require("jit")
+        local jutil = require("jit.util")
+        local hasVmdef, vmdef = pcall(require, "jit.vmdef")
+
+        local names = {}
+        for i = 1, #bindingNames do
+            local f = _G[bindingNames[i]]
+            if f ~= nil then names[f] = bindingNames[i] end
+        end
+
+        local function location(func, pc)
+            if names[func] then return names[func] end
+            local info = jutil.funcinfo(func, pc)
+            if info.loc then return info.loc end
+            if info.ffid then return "builtin#" .. info.ffid end
+            return "?"
+        end
+
+        local function handler(what, tr, func, pc, code, info)
+            if what == "start" then
+                record(what, tr, location(func, pc), "", "")
+            elseif what == "abort" then
+                local binding = type(info) == "function" and names[info] or ""
+                local reason = "trace error " .. tostring(code)
+                if hasVmdef and vmdef.traceerr[code] then
+                    local detail = info
+                    if type(info) == "function" then detail = location(info) end
+                    local ok, text = pcall(string.format, vmdef.traceerr[code], detail)
+                    reason = ok and text or vmdef.traceerr[code]
+                end
+                record(what, tr, location(func, pc), reason, binding)
+            else
+                record(what, tr or 0, "", "", "")
+            end
+        end
+
+        return function(on)
+            if on then
+                jit.attach(handler, "trace")
+            else
+                jit.attach(handler)
+            end
+        end
+    end
+)";
+
+} // namespace
+
+bool JitDiagnostics::enable(sol::state_view lua, const std::vector<std::string>& bindingNames) {
+    if (enabled) return true;
+
+    if (!toggle.valid()) {
+        sol::table holder = lua.create_table();
+        holder.set_function("record", [this](const std::string& what, int trace, const std::string& location,
+                                             const std::string& reason, const std::string& binding) {
+            record(what, trace, location, reason, binding);
+        });
+
+        sol::function recordEvent = holder["record"];
+
+        sol::protected_function setup = lua.script(ATTACH_SCRIPT);
+        sol::protected_function_result result = setup(recordEvent, sol::as_table(bindingNames));
+        if (!result.valid()) {
+            sol::error err = result;
+            logging::error("JIT diagnostics unavailable: ", err.what());
+            return false;
+        }
+        toggle = result.get<sol::protected_function>();
+    }
+
+    sol::protected_function_result result = toggle(true);
+    if (!result.valid()) {
+        sol::error err = result;
+        logging::error("jit.attach failed: ", err.what());
+        return false;
+    }
+    enabled = true;
+    return true;
+}
+
+void JitDiagnostics::disable() {
+    if (!enabled) return;
+    toggle(false);
+    enabled = false;
+    activeTraces.clear();
+}
+
+void JitDiagnostics::record(const std::string& what, int trace, const std::string& location,
+                            const std::string& reason, const std::string& binding) {
+    if (what == "start") {
+        activeTraces[trace] = location;
+        functions[location].starts++;
+        starts++;
+    } else if (what == "stop") {
+        auto it = activeTraces.find(trace);
+        if (it != activeTraces.end()) {
+            functions[it->second].stops++;
+            activeTraces.erase(it);
+        }
+        stops++;
+    } else if (what == "abort") {
+        // Attribute to the function the trace started in; the abort site goes
+        // into the reason
+        auto it = activeTraces.find(trace);
+        const std::string& owner = it != activeTraces.end() ? it->second : location;
+        FunctionStats& stats = functions[owner];
+        stats.aborts++;
+        stats.reasons[location == owner ? reason : reason + " at " + location]++;
+        if (it != activeTraces.end()) activeTraces.erase(it);
+        if (!binding.empty()) bindingAborts[binding]++;
+        aborts++;
+    } else if (what == "flush") {
+        // Trace numbers are reused after a flush
+        activeTraces.clear();
+        flushes++;
+    }
+}
+
+std::string JitDiagnostics::report(size_t maxFunctions) const {
+    char line[512];
+    std::string out;
+
+    std::snprintf(line, sizeof(line), "JIT traces: %llu started, %llu compiled, %llu aborted, %llu flushes\n",
+                  static_cast<unsigned long long>(starts), static_cast<unsigned long long>(stops),
+                  static_cast<unsigned long long>(aborts), static_cast<unsigned long long>(flushes));
+    out += line;
+
+    std::vector<std::pair<std::string, const FunctionStats*>> ranked;
+    for (const auto& [location, stats] : functions) {
+        if (stats.aborts > 0) ranked.emplace_back(location, &stats);
+    }
+    std::sort(ranked.begin(), ranked.end(), [](const auto& a, const auto& b) {
+        return a.second->aborts > b.second->aborts;
+    });
+
+    if (!ranked.empty()) {
+        out += "Functions by trace aborts:\n";
+        out += "  aborts compiled  started  function (top reason)\n";
+    }
+    for (size_t i = 0; i < ranked.size() && i < maxFunctions; i++) {
+        const FunctionStats& stats = *ranked[i].second;
+        auto top = std::max_element(stats.reasons.begin(), stats.reasons.end(),
+            [](const auto& a, const auto& b) { return a.second < b.second; });
+        std::snprintf(line, sizeof(line), "  %6llu %8llu %8llu  %s (%s x%llu)\n",
+                      static_cast<unsigned long long>(stats.aborts), static_cast<unsigned long long>(stats.stops),
+                      static_cast<unsigned long long>(stats.starts), ranked[i].first.c_str(),
+                      top->first.c_str(), static_cast<unsigned long long>(top->second));
+        out += line;
+    }
+
+    if (!bindingAborts.empty()) {
+        std::vector<std::pair<std::string, uint64_t>> bindings(bindingAborts.begin(), bindingAborts.end());
+        std::sort(bindings.begin(), bindings.end(), [](const auto& a, const auto& b) {
+            return a.second > b.second;
+        });
+        out += "Trace aborts by native binding:\n";
+        for (const auto& [name, count] : bindings) {
+            std::snprintf(line, sizeof(line), "  %6llu  %s\n", static_cast<unsigned long long>(count), name.c_str());
+            out += line;
+        }
+    }
+    return out;
+}
+
+void JitDiagnostics::clear() {
+    activeTraces.clear();
+    functions.clear();
+    bindingAborts.clear();
+    starts = stops = aborts = flushes = 0;
+}
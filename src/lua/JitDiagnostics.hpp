@@ -0,0 +1,54 @@
+#ifndef JITDIAGNOSTICS_HPP
+#define JITDIAGNOSTICS_HPP
+
+#include <sol/sol.hpp>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// JIT trace health report.
+//
+// Attaches a handler to LuaJIT's trace events (jit.attach) and aggregates
+// trace starts, completions and aborts per function, with the abort
+// reasons. Aborts caused by calling a native binding (the usual
+// "NYI: C function" from sol3 calls) are also counted per binding, which
+// shows where a fast path would pay off.
+class JitDiagnostics {
+public:
+    struct FunctionStats {
+        uint64_t starts = 0;
+        uint64_t stops = 0;
+        uint64_t aborts = 0;
+        std::map<std::string, uint64_t> reasons;
+    };
+
+private:
+    sol::protected_function toggle;     // toggle(bool) from the attach script
+    bool enabled = false;
+
+    std::unordered_map<int, std::string> activeTraces;   // Trace number -> start location
+    std::map<std::string, FunctionStats> functions;      // Keyed by "chunk:line"
+    std::map<std::string, uint64_t> bindingAborts;
+    uint64_t starts = 0;
+    uint64_t stops = 0;
+    uint64_t aborts = 0;
+    uint64_t flushes = 0;
+
+public:
+    // Attach to trace events; bindingNames are the globals to count aborts for
+    bool enable(sol::state_view lua, const std::vector<std::string>& bindingNames);
+    void disable();
+    bool isEnabled() const { return enabled; }
+
+    // Ranked report: functions by aborts, then aborts per binding
+    std::string report(size_t maxFunctions = 20) const;
+    void clear();
+
+private:
+    void record(const std::string& what, int trace, const std::string& location,
+                const std::string& reason, const std::string& binding);
+};
+
+#endif // JITDIAGNOSTICS_HPP
@@ -0,0 +1,176 @@
+#include "LuaAllocator.hpp"
+#include "../core/Log.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+
+LuaAllocator::~LuaAllocator() {
+    reset();
+}
+
+sol::state LuaAllocator::createState() {
+    // lua_newstate returns NULL on LuaJIT builds that insist on their own
+    // allocator, and sol::state cannot recover from that, so probe first
+    pooling = true;
+    lua_State* probe = lua_newstate(&LuaAllocator::allocate, this);
+    if (probe) {
+        lua_close(probe);
+        reset();
+        pooling = true;
+        return sol::state(sol::default_at_panic, &LuaAllocator::allocate, this);
+    }
+
+    // Non-GC64 LuaJIT: keep its allocator and count through a wrapper. The
+    // state already holds blocks of unknown size classes, so no pooling.
+    reset();
+    logging::warn("Lua allocator: custom allocators need a GC64 LuaJIT build; "
+                  "using the default allocator with statistics and limit only");
+    sol::state state;
+    lua_State* L = state.lua_state();
+    baseAlloc = lua_getallocf(L, &baseUserData);
+    liveBytes = static_cast<size_t>(lua_gc(L, LUA_GCCOUNT, 0)) * 1024 + lua_gc(L, LUA_GCCOUNTB, 0);
+    peakBytes = liveBytes;
+    lua_setallocf(L, &LuaAllocator::allocate, this);
+    return state;
+}
+
+void LuaAllocator::beginFrame() {
+    if (frameFailures > 0) {
+        logging::error("Lua heap limit of ", limit, " bytes reached: refused ",
+                       frameFailures, " allocation(s)");
+    }
+    lastFrameAllocations = frameAllocations;
+    lastFrameFrees = frameFrees;
+    lastFrameBytes = frameBytes;
+    frameAllocations = frameFrees = frameBytes = frameFailures = 0;
+}
+
+LuaAllocator::Stats LuaAllocator::getStats() const {
+    Stats result;
+    result.liveBytes = liveBytes;
+    result.peakBytes = peakBytes;
+    result.limitBytes = limit;
+    result.pooledBytes = chunks.size() * CHUNK_SIZE;
+    result.allocations = allocations;
+    result.frees = frees;
+    result.frameAllocations = lastFrameAllocations;
+    result.frameFrees = lastFrameFrees;
+    result.frameBytes = lastFrameBytes;
+    result.failures = failures;
+    result.pooling = pooling;
+    return result;
+}
+
+void* LuaAllocator::allocate(void* ud, void* ptr, size_t osize, size_t nsize) {
+    auto* self = static_cast<LuaAllocator*>(ud);
+    if (!ptr) osize = 0;
+
+    if (nsize == 0) {
+        if (ptr) {
+            if (self->pooling) {
+                self->release(ptr, osize);
+            } else {
+                self->baseAlloc(self->baseUserData, ptr, osize, 0);
+            }
+            self->liveBytes -= std::min(osize, self->liveBytes);
+            self->frees++;
+            self->frameFrees++;
+        }
+        return nullptr;
+    }
+
+    // Only growth can hit the limit; Lua expects shrinking to always succeed
+    size_t growth = nsize > osize ? nsize - osize : 0;
+    if (growth > 0 && self->limit > 0 && self->liveBytes + growth > self->limit) {
+        self->failures++;
+        self->frameFailures++;
+        return nullptr;
+    }
+
+    void* block = self->pooling ? self->resize(ptr, osize, nsize)
+                                : self->baseAlloc(self->baseUserData, ptr, osize, nsize);
+    if (!block) return nullptr;
+
+    self->liveBytes = self->liveBytes - std::min(osize, self->liveBytes) + nsize;
+    self->peakBytes = std::max(self->peakBytes, self->liveBytes);
+    self->frameBytes += growth;
+    if (!ptr) {
+        self->allocations++;
+        self->frameAllocations++;
+    }
+    return block;
+}
+
+void* LuaAllocator::resize(void* ptr, size_t osize, size_t nsize) {
+    bool oldSmall = ptr && osize <= MAX_SMALL;
+    bool newSmall = nsize <= MAX_SMALL;
+
+    if (ptr && !oldSmall && !newSmall) {
+        void* block = std::realloc(ptr, nsize);
+        return block ? block : (nsize <= osize ? ptr : nullptr);
+    }
+    if (oldSmall && newSmall && sizeClassOf(osize) == sizeClassOf(nsize)) {
+        return ptr;
+    }
+
+    void* block = newSmall ? takeBlock(sizeClassOf(nsize)) : std::malloc(nsize);
+    if (!block) {
+        // A failed shrink keeps the larger block (released later by its new size)
+        return (ptr && nsize <= osize) ? ptr : nullptr;
+    }
+    if (ptr) {
+        std::memcpy(block, ptr, std::min(osize, nsize));
+        release(ptr, osize);
+    }
+    return block;
+}
+
+void* LuaAllocator::takeBlock(size_t sizeClass) {
+    if (FreeBlock* block = freeLists[sizeClass]) {
+        freeLists[sizeClass] = block->next;
+        return block;
+    }
+
+    size_t blockSize = (sizeClass + 1) * GRANULE;
+    if (chunkRemaining < blockSize) {
+        void* chunk = std::malloc(CHUNK_SIZE);
+        if (!chunk) return nullptr;
+        chunks.push_back(chunk);
+        chunkCursor = static_cast<char*>(chunk);
+        chunkRemaining = CHUNK_SIZE;
+    }
+    void* block = chunkCursor;
+    chunkCursor += blockSize;
+    chunkRemaining -= blockSize;
+    return block;
+}
+
+void LuaAllocator::release(void* ptr, size_t size) {
+    if (size > MAX_SMALL) {
+        std::free(ptr);
+        return;
+    }
+    auto* block = static_cast<FreeBlock*>(ptr);
+    size_t sizeClass = sizeClassOf(std::max<size_t>(size, 1));
+    block->next = freeLists[sizeClass];
+    freeLists[sizeClass] = block;
+}
+
+void LuaAllocator::reset() {
+    for (void* chunk : chunks) {
+        std::free(chunk);
+    }
+    chunks.clear();
+    std::fill(std::begin(freeLists), std::end(freeLists), nullptr);
+    chunkCursor = nullptr;
+    chunkRemaining = 0;
+
+    baseAlloc = nullptr;
+    baseUserData = nullptr;
+    pooling = false;
+    liveBytes = peakBytes = 0;
+    allocations = frees = failures = 0;
+    frameAllocations = frameFrees = frameBytes = frameFailures = 0;
+    lastFrameAllocations = lastFrameFrees = lastFrameBytes = 0;
+}
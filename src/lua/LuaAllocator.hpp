@@ -0,0 +1,97 @@
+#ifndef LUAALLOCATOR_HPP
+#define LUAALLOCATOR_HPP
+
+#include <sol/sol.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Allocator for the Lua state: small blocks come from size-class free lists
+// carved out of larger chunks, larger blocks go to malloc. It keeps live/peak
+// byte counts and per-frame allocation counts, and can cap the heap: a
+// request that would go over the limit fails, which Lua reports as a
+// "not enough memory" error in the running script instead of taking the
+// process down.
+//
+// LuaJIT only accepts a custom allocator in GC64 (and 32-bit) builds. On
+// other 64-bit builds the state keeps LuaJIT's own allocator and this class
+// only wraps it for the statistics and the limit (no pooling).
+class LuaAllocator {
+public:
+    struct Stats {
+        size_t liveBytes = 0;
+        size_t peakBytes = 0;
+        size_t limitBytes = 0;           // 0 = unlimited
+        size_t pooledBytes = 0;          // Chunk memory reserved for small blocks
+        uint64_t allocations = 0;        // Since start
+        uint64_t frees = 0;
+        uint64_t frameAllocations = 0;   // Last completed frame
+        uint64_t frameFrees = 0;
+        uint64_t frameBytes = 0;         // Bytes requested in the last frame
+        uint64_t failures = 0;           // Requests refused by the limit
+        bool pooling = false;
+    };
+
+private:
+    static const size_t GRANULE = 16;               // Size class step (and block alignment)
+    static const size_t MAX_SMALL = 512;            // Largest pooled block
+    static const size_t CLASS_COUNT = MAX_SMALL / GRANULE;
+    static const size_t CHUNK_SIZE = 64 * 1024;
+
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    FreeBlock* freeLists[CLASS_COUNT] = {};
+    std::vector<void*> chunks;
+    char* chunkCursor = nullptr;
+    size_t chunkRemaining = 0;
+
+    // Wrapped allocator when LuaJIT would not take ours (no pooling)
+    lua_Alloc baseAlloc = nullptr;
+    void* baseUserData = nullptr;
+    bool pooling = false;
+
+    size_t limit = 0;
+    size_t liveBytes = 0;
+    size_t peakBytes = 0;
+    uint64_t allocations = 0;
+    uint64_t frees = 0;
+    uint64_t failures = 0;
+
+    // Counters of the frame in progress and of the last completed one
+    uint64_t frameAllocations = 0, frameFrees = 0, frameBytes = 0, frameFailures = 0;
+    uint64_t lastFrameAllocations = 0, lastFrameFrees = 0, lastFrameBytes = 0;
+
+public:
+    LuaAllocator() = default;
+    ~LuaAllocator();
+
+    LuaAllocator(const LuaAllocator&) = delete;
+    LuaAllocator& operator=(const LuaAllocator&) = delete;
+
+    // Create a Lua state that allocates through this allocator. The
+    // allocator must outlive the state.
+    sol::state createState();
+
+    // Heap cap in bytes (0 = unlimited)
+    void setLimit(size_t bytes) { limit = bytes; }
+    size_t getLimit() const { return limit; }
+
+    // Start a new frame: the counts gathered so far become the last frame's
+    void beginFrame();
+
+    Stats getStats() const;
+
+    static void* allocate(void* ud, void* ptr, size_t osize, size_t nsize);
+
+private:
+    void* resize(void* ptr, size_t osize, size_t nsize);
+    void* takeBlock(size_t sizeClass);
+    void release(void* ptr, size_t size);
+    void reset();
+
+    static size_t sizeClassOf(size_t size) { return (size + GRANULE - 1) / GRANULE - 1; }
+};
+
+#endif // LUAALLOCATOR_HPP
@@ -1,10 +1,98 @@
 #include "LuaBindings.hpp"
 #include "../Application.hpp"
-#include <iostream>
+#include "../core/Trace.hpp"
+#include "../core/Log.hpp"
+#include <algorithm>
+#include <string_view>
+#include <unordered_set>
+
+namespace {
+
+// Convert normalized Lua color components to an SDL color
+SDL_Color toColor(float r, float g, float b, float a) {
+    return SDL_Color{
+        static_cast<Uint8>(r * 255),
+        static_cast<Uint8>(g * 255),
+        static_cast<Uint8>(b * 255),
+        static_cast<Uint8>(a * 255)
+    };
+}
+
+// Result of an asset future as Lua values: (fontId, nil), (nil, error) or (nil, "pending")
+std::tuple<sol::object, sol::object> assetResult(sol::state& lua, const AssetLoader::Job& job) {
+    switch (job.state) {
+    case AssetLoader::AssetState::Ready:
+        return {sol::make_object(lua, job.fontId), sol::nil};
+    case AssetLoader::AssetState::Failed:
+        return {sol::nil, sol::make_object(lua, job.error)};
+    default:
+        return {sol::nil, sol::make_object(lua, "pending")};
+    }
+}
+
+// Apply the layout fields present in a Lua options table to a node.
+// Missing fields are left untouched so add() options can tweak existing nodes.
+void applyLayoutOptions(LayoutNode& node, const sol::table& options) {
+    sol::optional<std::string> direction = options["direction"];
+    if (direction) {
+        if (*direction == "row") {
+            node.setDirection(LayoutNode::Direction::Row);
+        } else if (*direction == "column") {
+            node.setDirection(LayoutNode::Direction::Column);
+        } else if (*direction == "stack") {
+            node.setDirection(LayoutNode::Direction::Stack);
+        } else {
+            throw sol::error("Unknown layout direction: " + *direction);
+        }
+    }
+
+    sol::optional<float> padding = options["padding"];
+    sol::optional<float> paddingLeft = options["paddingLeft"];
+    sol::optional<float> paddingTop = options["paddingTop"];
+    sol::optional<float> paddingRight = options["paddingRight"];
+    sol::optional<float> paddingBottom = options["paddingBottom"];
+    if (padding || paddingLeft || paddingTop || paddingRight || paddingBottom) {
+        // Sides not given keep their value unless `padding` sets them all
+        SDL_FRect current = node.getPadding();
+        node.setPadding(paddingLeft.value_or(padding.value_or(current.x)),
+                        paddingTop.value_or(padding.value_or(current.y)),
+                        paddingRight.value_or(padding.value_or(current.w)),
+                        paddingBottom.value_or(padding.value_or(current.h)));
+    }
+
+    sol::optional<float> gap = options["gap"];
+    if (gap) node.setGap(*gap);
+
+    sol::optional<float> flex = options["flex"];
+    if (flex) node.setFlex(*flex);
+
+    sol::optional<float> width = options["width"];
+    sol::optional<float> height = options["height"];
+    if (width || height) {
+        node.setFixedSize(width.value_or(node.getFixedWidth()), height.value_or(node.getFixedHeight()));
+    }
+}
+
+} // namespace
+
+Application* LuaBindings::boundApp = nullptr;
 
 void LuaBindings::setupBindings(Application* app, sol::state& lua) {
+    boundApp = app;
+
+    // Globals that exist before binding (standard libraries) are not ours
+    std::unordered_set<std::string> libraryGlobals;
+    for (const auto& entry : lua.globals()) {
+        if (entry.first.get_type() == sol::type::string) {
+            libraryGlobals.insert(entry.first.as<std::string>());
+        }
+    }
+
     // Expose quit function
-    lua["quit"] = [app]() { app->running = false; };
+    lua["quit"] = [app](sol::optional<int> exitCode) {
+        if (exitCode) app->exitCode = *exitCode;
+        app->running = false;
+    };
 
     // Expose window functions
     lua["setWindowTitle"] = [app](const std::string& title) {
@@ -29,26 +117,47 @@ void LuaBindings::setupBindings(Application* app, sol::state& lua) {
         return size;
     };
 
+    // local w, h = getWindowDimensions() - no table, for per-frame use
+    lua["getWindowDimensions"] = [app]() -> std::tuple<int, int> {
+        return {app->windowWidth, app->windowHeight};
+    };
+
     // Expose drawing functions
     lua["drawRect"] = [app](float x, float y, float w, float h, float r, float g, float b, float a = 1.0f) {
-        if (app->renderer) {
-            SDL_SetRenderDrawColor(app->renderer,
-                static_cast<Uint8>(r * 255),
-                static_cast<Uint8>(g * 255),
-                static_cast<Uint8>(b * 255),
-                static_cast<Uint8>(a * 255));
-            SDL_FRect rect = {x, y, w, h};
-            SDL_RenderFillRect(app->renderer, &rect);
-        }
+        app->compositor.fillRect(x, y, w, h, toColor(r, g, b, a));
     };
 
     // Expose print function
-    lua["print"] = [](const std::string& msg) {
-        std::cout << "[Lua] " << msg << std::endl;
+    lua["print"] = [](std::string_view msg) {
+        logging::info("[Lua] ", msg);
+    };
+
+    // Leveled logging through the async logger: log.warn("msg"), ...
+    // Lines below the level set with setLogLevel are skipped before formatting
+    sol::table log = lua.create_named_table("log");
+    log["debug"] = [](std::string_view msg) { logging::debug("[Lua] ", msg); };
+    log["info"] = [](std::string_view msg) { logging::info("[Lua] ", msg); };
+    log["warn"] = [](std::string_view msg) { logging::warn("[Lua] ", msg); };
+    log["error"] = [](std::string_view msg) { logging::error("[Lua] ", msg); };
+
+    lua["setLogLevel"] = [](const std::string& name) -> bool {
+        logging::Level level;
+        if (!logging::parseLevel(name, level)) return false;
+        logging::setLevel(level);
+        return true;
+    };
+
+    lua["getLogStats"] = [&lua]() -> sol::table {
+        logging::Stats stats = logging::getStats();
+        return lua.create_table_with(
+            "written", stats.written,
+            "dropped", stats.dropped,
+            "collapsed", stats.collapsed);
     };
 
     // Font management functions
     lua["loadFont"] = [app, &lua](const std::string& path, float size) -> sol::object {
+        TRACE_ZONE("loadFont");
         int fontId = app->fontManager.loadFont(path, size);
         if (fontId < 0) {
             return sol::nil;
@@ -72,26 +181,279 @@ void LuaBindings::setupBindings(Application* app, sol::state& lua) {
     };
 
     lua["closeFont"] = [app](int fontId) {
+        app->textLayouts.clear();
+        app->textMeasures.clear();
         app->fontManager.closeFont(fontId);
     };
 
+    // Font instance cache: sizes are rounded to `quantum` points and the least
+    // recently used instances beyond `maxInstances` are closed
+    lua["setFontCacheLimits"] = [app](int maxInstances, sol::optional<float> quantum) {
+        float previous = app->fontManager.getCacheStats().sizeQuantum;
+        app->fontManager.setCacheLimits(maxInstances > 0 ? static_cast<size_t>(maxInstances) : 1,
+                                        quantum.value_or(previous));
+        // Cached sizes were measured at the sizes the old quantum picked
+        if (app->fontManager.getCacheStats().sizeQuantum != previous) {
+            app->textLayouts.clear();
+            app->textMeasures.clear();
+        }
+    };
+
+    lua["getFontCacheStats"] = [app, &lua]() -> sol::table {
+        FontManager::CacheStats stats = app->fontManager.getCacheStats();
+        sol::table result = lua.create_table();
+        result["instances"] = stats.instances;
+        result["pinned"] = stats.pinned;
+        result["maxInstances"] = stats.maxInstances;
+        result["quantum"] = stats.sizeQuantum;
+        result["hits"] = stats.hits;
+        result["misses"] = stats.misses;
+        result["evictions"] = stats.evictions;
+        return result;
+    };
+
+    // Fallback chains: setFontFallbacks(fontId, {cjkFontId, emojiFontId})
+    lua["setFontFallbacks"] = [app](int fontId, sol::table chain) {
+        std::vector<int> ids;
+        for (size_t i = 1; i <= chain.size(); i++) {
+            ids.push_back(chain.get<int>(i));
+        }
+        app->fontManager.setFallbacks(fontId, ids);
+        app->textLayouts.clear();
+        app->textMeasures.clear();
+    };
+
+    lua["getFontFallbacks"] = [app, &lua](int fontId) -> sol::table {
+        sol::table result = lua.create_table();
+        int i = 1;
+        for (int fallbackId : app->fontManager.getFallbacks(fontId)) {
+            result[i++] = fallbackId;
+        }
+        return result;
+    };
+
+    // Persistent glyph cache: setGlyphCache("cache/glyphs") enables it, nil disables
+    lua["setGlyphCache"] = [app](sol::optional<std::string> directory) {
+        app->glyphAtlases.setDirectory(directory.value_or(""));
+    };
+
+    // Rasterise (or load from disk) every character of charset for the current
+    // font at `size` (default: current size); returns the number rasterised
+    lua["prewarmGlyphs"] = [app](const std::string& charset, sol::optional<float> size) -> int {
+        TRACE_ZONE("prewarmGlyphs");
+        FontManager& fonts = app->fontManager;
+        if (fonts.getCurrentFontId() == 0) return 0;
+        TTF_Font* font = fonts.getFont(fonts.getCurrentFontId(), size.value_or(fonts.getCurrentFontSize()));
+        return app->glyphAtlases.prewarm(font, charset);
+    };
+
+    lua["saveGlyphCache"] = [app]() {
+        app->glyphAtlases.save();
+    };
+
+    lua["getGlyphCacheStats"] = [app, &lua]() -> sol::table {
+        GlyphAtlasCache::Stats stats = app->glyphAtlases.getStats();
+        sol::table result = lua.create_table();
+        result["atlases"] = stats.atlases;
+        result["glyphs"] = stats.glyphs;
+        result["rasterised"] = stats.rasterised;
+        result["diskLoads"] = stats.diskLoads;
+        result["diskSaves"] = stats.diskSaves;
+        result["atlasDraws"] = stats.atlasDraws;
+        result["fallbackDraws"] = stats.fallbackDraws;
+        return result;
+    };
+
+    // Asynchronous loading
+    // Files are read and decoded on worker threads; the font is registered and
+    // callbacks run on the main thread at the start of the next update.
+    auto futureType = lua.new_usertype<AssetLoader::Job>("AssetFuture",
+        sol::no_constructor,
+
+        "isDone", [](const AssetLoader::Job& self) -> bool {
+            return self.isDone();
+        },
+        "isReady", [](const AssetLoader::Job& self) -> bool {
+            return self.state == AssetLoader::AssetState::Ready;
+        },
+        "failed", [](const AssetLoader::Job& self) -> bool {
+            return self.state == AssetLoader::AssetState::Failed;
+        },
+        "getError", [](const AssetLoader::Job& self) -> std::string {
+            return self.error;
+        },
+        "getPath", [](const AssetLoader::Job& self) -> std::string {
+            return self.path;
+        },
+
+        // Returns the font ID, or nil plus "pending" / the error message
+        "get", [&lua](const AssetLoader::Job& self) -> std::tuple<sol::object, sol::object> {
+            return assetResult(lua, self);
+        },
+
+        // Blocks the main thread until the asset is loaded (prefer await in a coroutine)
+        "wait", [app, &lua](std::shared_ptr<AssetLoader::Job> self) -> std::tuple<sol::object, sol::object> {
+            app->assetLoader.wait(self);
+            return assetResult(lua, *self);
+        },
+
+        // callback(fontId) on success, callback(nil, error) on failure
+        "onComplete", [app, &lua](std::shared_ptr<AssetLoader::Job> self, sol::protected_function callback) {
+            app->assetLoader.onComplete(self, [&lua, callback](const AssetLoader::Job& job) {
+                auto [value, error] = assetResult(lua, job);
+                sol::protected_function_result result = callback(value, error);
+                if (!result.valid()) {
+                    sol::error err = result;
+                    logging::error("Lua asset callback error: ", err.what());
+                }
+            });
+        }
+    );
+
+    // Inside a coroutine (see runAsync) await yields until the asset is done;
+    // on the main thread it falls back to a blocking wait
+    sol::function await = lua.script(R"(
+        return function(self)
+            if coroutine.running() then
+                while not self:isDone() do
+                    coroutine.yield()
+                end
+                return self:get()
+            end
+            return self:wait()
+        end
+    )");
+    futureType["await"] = await;
+
+    lua["loadFontAsync"] = [app](const std::string& path, float size) {
+        return app->assetLoader.loadFont(path, size);
+    };
+
+    // runAsync(fn, ...) runs fn as a coroutine, resumed once per frame while it
+    // is suspended (typically in future:await())
+    sol::function resumeAsyncTasks = lua.script(R"(
+        local tasks = {}
+
+        local function step(co, ...)
+            local ok, err = coroutine.resume(co, ...)
+            if not ok then
+                print("runAsync error: " .. tostring(err))
+            end
+            return coroutine.status(co) ~= "dead"
+        end
+
+        function runAsync(fn, ...)
+            local co = coroutine.create(fn)
+            if step(co, ...) then
+                tasks[#tasks + 1] = co
+            end
+        end
+
+        return function()
+            local n = #tasks
+            if n == 0 then return end
+            local alive = {}
+            for i = 1, n do
+                if step(tasks[i]) then
+                    alive[#alive + 1] = tasks[i]
+                end
+            end
+            -- Tasks started while resuming were appended after n
+            for i = n + 1, #tasks do
+                alive[#alive + 1] = tasks[i]
+            end
+            tasks = alive
+        end
+    )");
+    app->resumeAsyncTasks = resumeAsyncTasks;
+
     // Text measurement functions
-    lua["measureText"] = [app, &lua](const std::string& text) -> sol::table {
+    lua["measureText"] = [app, &lua](std::string_view text) -> sol::table {
+        TRACE_ZONE("measureText");
         sol::table result = lua.create_table();
         result["width"] = 0;
         result["height"] = 0;
 
-        TTF_Font* font = app->fontManager.getCurrentFont(app->fontManager.getCurrentFontSize());
+        FontManager& fonts = app->fontManager;
+        TTF_Font* font = fonts.getCurrentFont(fonts.getCurrentFontSize());
         if (!font) return result;
 
         int w = 0, h = 0;
-        if (TTF_GetStringSize(font, text.c_str(), text.length(), &w, &h)) {
+        if (app->textMeasures.measure(fonts, font, fonts.getCurrentFontId(), fonts.getCurrentFontSize(),
+                                      text.data(), text.length(), w, h)) {
             result["width"] = w;
             result["height"] = h;
         }
         return result;
     };
 
+    // local w, h = measureTextSize(text) - same as measureText without a table
+    lua["measureTextSize"] = [app](std::string_view text) -> std::tuple<int, int> {
+        FontManager& fonts = app->fontManager;
+        TTF_Font* font = fonts.getCurrentFont(fonts.getCurrentFontSize());
+        int w = 0, h = 0;
+        app->textMeasures.measure(fonts, font, fonts.getCurrentFontId(), fonts.getCurrentFontSize(),
+                                  text.data(), text.length(), w, h);
+        return {w, h};
+    };
+
+    // measureTexts(list [, widths, heights]) -> widths, heights
+    // Measures every string (or number) in list in one call; pass the tables
+    // returned by a previous call to have them refilled instead of reallocated
+    lua["measureTexts"] = [app](sol::table list, sol::optional<sol::table> widthsOut,
+                                sol::optional<sol::table> heightsOut, sol::this_state s)
+            -> std::tuple<sol::table, sol::table> {
+        lua_State* L = s;
+        TRACE_ZONE("measureTexts");
+        int count = static_cast<int>(list.size());
+        sol::table widths = widthsOut ? *widthsOut : sol::table(L, sol::new_table(count, 0));
+        sol::table heights = heightsOut ? *heightsOut : sol::table(L, sol::new_table(count, 0));
+
+        FontManager& fonts = app->fontManager;
+        TTF_Font* font = fonts.getCurrentFont(fonts.getCurrentFontSize());
+        int fontId = fonts.getCurrentFontId();
+        float size = fonts.getCurrentFontSize();
+
+        // Raw stack access: no per-item sol objects or string copies
+        list.push(L);
+        int listIndex = lua_gettop(L);
+        widths.push(L);
+        heights.push(L);
+        for (int i = 1; i <= count; i++) {
+            lua_rawgeti(L, listIndex, i);
+            size_t length = 0;
+            const char* text = lua_tolstring(L, -1, &length);
+            int w = 0, h = 0;
+            if (text) {
+                app->textMeasures.measure(fonts, font, fontId, size, text, length, w, h);
+            }
+            lua_pop(L, 1);
+            lua_pushinteger(L, w);
+            lua_rawseti(L, listIndex + 1, i);
+            lua_pushinteger(L, h);
+            lua_rawseti(L, listIndex + 2, i);
+        }
+        // Reused tables: drop entries left from a longer earlier list
+        for (int out = listIndex + 1; out <= listIndex + 2; out++) {
+            for (int i = static_cast<int>(lua_objlen(L, out)); i > count; i--) {
+                lua_pushnil(L);
+                lua_rawseti(L, out, i);
+            }
+        }
+        lua_pop(L, 3);
+
+        return {widths, heights};
+    };
+
+    lua["getMeasureCacheStats"] = [app, &lua]() -> sol::table {
+        TextMeasureCache::Stats stats = app->textMeasures.getStats();
+        sol::table result = lua.create_table();
+        result["entries"] = stats.entries;
+        result["hits"] = stats.hits;
+        result["misses"] = stats.misses;
+        return result;
+    };
+
     lua["getFontHeight"] = [app]() -> int {
         TTF_Font* font = app->fontManager.getCurrentFont(app->fontManager.getCurrentFontSize());
         if (!font) return 0;
@@ -101,63 +463,111 @@ void LuaBindings::setupBindings(Application* app, sol::state& lua) {
     // Text rendering function
     lua["drawText"] = sol::overload(
         // drawText(text, x, y, r, g, b, a)
-        [app](const std::string& text, float x, float y, float r, float g, float b, float a) {
-            TTF_Font* font = app->fontManager.getCurrentFont(app->fontManager.getCurrentFontSize());
-            if (!font || !app->textEngine || !app->renderer) return;
-
-            TTF_Text* ttfText = TTF_CreateText(app->textEngine, font, text.c_str(), text.length());
-            if (!ttfText) return;
-
-            SDL_Color color = {
-                static_cast<Uint8>(r * 255),
-                static_cast<Uint8>(g * 255),
-                static_cast<Uint8>(b * 255),
-                static_cast<Uint8>(a * 255)
-            };
-            TTF_SetTextColor(ttfText, color.r, color.g, color.b, color.a);
-            TTF_DrawRendererText(ttfText, x, y);
-            TTF_DestroyText(ttfText);
+        [app](std::string_view text, float x, float y, float r, float g, float b, float a) {
+            TRACE_ZONE("drawText");
+            FontManager& fonts = app->fontManager;
+            TTF_Font* font = fonts.getCurrentFont(fonts.getCurrentFontSize());
+            drawTextRuns(fonts, app->compositor, font, fonts.getCurrentFontId(), fonts.getCurrentFontSize(),
+                         text, x, y, toColor(r, g, b, a));
         },
         // drawText(text, x, y, r, g, b) - default alpha 1.0
-        [app](const std::string& text, float x, float y, float r, float g, float b) {
-            TTF_Font* font = app->fontManager.getCurrentFont(app->fontManager.getCurrentFontSize());
-            if (!font || !app->textEngine || !app->renderer) return;
-
-            TTF_Text* ttfText = TTF_CreateText(app->textEngine, font, text.c_str(), text.length());
-            if (!ttfText) return;
-
-            SDL_Color color = {
-                static_cast<Uint8>(r * 255),
-                static_cast<Uint8>(g * 255),
-                static_cast<Uint8>(b * 255),
-                255
-            };
-            TTF_SetTextColor(ttfText, color.r, color.g, color.b, color.a);
-            TTF_DrawRendererText(ttfText, x, y);
-            TTF_DestroyText(ttfText);
+        [app](std::string_view text, float x, float y, float r, float g, float b) {
+            TRACE_ZONE("drawText");
+            FontManager& fonts = app->fontManager;
+            TTF_Font* font = fonts.getCurrentFont(fonts.getCurrentFontSize());
+            drawTextRuns(fonts, app->compositor, font, fonts.getCurrentFontId(), fonts.getCurrentFontSize(),
+                         text, x, y, toColor(r, g, b, 1.0f));
         },
         // drawText(text, x, y, size, r, g, b, a) - with per-call size
-        [app](const std::string& text, float x, float y, float size, float r, float g, float b, float a) {
-            if (app->fontManager.getCurrentFontId() == 0 || !app->textEngine || !app->renderer) return;
-
-            TTF_Font* font = app->fontManager.getFont(app->fontManager.getCurrentFontId(), size);
-            if (!font) return;
-
-            TTF_Text* ttfText = TTF_CreateText(app->textEngine, font, text.c_str(), text.length());
-            if (!ttfText) return;
+        [app](std::string_view text, float x, float y, float size, float r, float g, float b, float a) {
+            TRACE_ZONE("drawText");
+            FontManager& fonts = app->fontManager;
+            if (fonts.getCurrentFontId() == 0) return;
+            TTF_Font* font = fonts.getFont(fonts.getCurrentFontId(), size);
+            drawTextRuns(fonts, app->compositor, font, fonts.getCurrentFontId(), size,
+                         text, x, y, toColor(r, g, b, a));
+        }
+    );
 
-            SDL_Color color = {
-                static_cast<Uint8>(r * 255),
-                static_cast<Uint8>(g * 255),
-                static_cast<Uint8>(b * 255),
-                static_cast<Uint8>(a * 255)
-            };
-            TTF_SetTextColor(ttfText, color.r, color.g, color.b, color.a);
-            TTF_DrawRendererText(ttfText, x, y);
-            TTF_DestroyText(ttfText);
+    // Text layout
+    // layoutText(text, opts) wraps, aligns and ellipsises a paragraph in C++ and
+    // returns a TextLayout; identical requests return the cached layout.
+    lua.new_usertype<TextLayout>("TextLayout",
+        sol::no_constructor,
+
+        "draw", sol::overload(
+            [app](const TextLayout& self, float x, float y, float r, float g, float b, float a) {
+                self.draw(app->fontManager, app->compositor, x, y, toColor(r, g, b, a));
+            },
+            [app](const TextLayout& self, float x, float y, float r, float g, float b) {
+                self.draw(app->fontManager, app->compositor, x, y, toColor(r, g, b, 1.0f));
+            }
+        ),
+        "getSize", [](const TextLayout& self) -> std::tuple<float, float> {
+            return {self.width, self.height};
+        },
+        "getLineCount", [](const TextLayout& self) -> int {
+            return static_cast<int>(self.lines.size());
+        },
+        // getLine(i) -> text, x, y, width (1-based)
+        "getLine", [](const TextLayout& self, int i) -> std::tuple<std::string, float, float, float> {
+            if (i < 1 || i > static_cast<int>(self.lines.size())) {
+                throw sol::error("TextLayout line index out of range");
+            }
+            const TextLayout::Line& line = self.lines[i - 1];
+            return {line.text, line.x, line.y, line.width};
+        },
+        // Byte offsets (0-based) in the source text where each line starts
+        "getLineBreaks", [&lua](const TextLayout& self) -> sol::table {
+            sol::table result = lua.create_table(static_cast<int>(self.lines.size()), 0);
+            for (size_t i = 0; i < self.lines.size(); i++) {
+                result[i + 1] = self.lines[i].sourceOffset;
+            }
+            return result;
         }
     );
 
+    lua["layoutText"] = [app](const std::string& text, sol::optional<sol::table> options)
+            -> std::shared_ptr<TextLayout> {
+        TRACE_ZONE("layoutText");
+        FontManager& fonts = app->fontManager;
+        if (fonts.getCurrentFontId() == 0) return nullptr;
+
+        TextLayoutParams params;
+        float size = fonts.getCurrentFontSize();
+        if (options) {
+            const sol::table& opts = *options;
+            params.width = opts.get_or("width", 0.0f);
+            params.wrap = opts.get_or("wrap", true);
+            params.ellipsis = opts.get_or("ellipsis", false);
+            params.maxLines = opts.get_or("maxLines", 0);
+            params.lineSpacing = opts.get_or("lineSpacing", 1.0f);
+            size = opts.get_or("size", size);
+
+            std::string align = opts.get_or<std::string>("align", "left");
+            if (align == "center") {
+                params.align = TextAlign::Center;
+            } else if (align == "right") {
+                params.align = TextAlign::Right;
+            }
+        }
+
+        return app->textLayouts.get(fonts, fonts.getCurrentFontId(), size, text, params);
+    };
+
+    lua["setTextLayoutCacheSize"] = [app](int entries) {
+        app->textLayouts.setCapacity(entries > 0 ? static_cast<size_t>(entries) : 1);
+    };
+
+    lua["getTextLayoutStats"] = [app, &lua]() -> sol::table {
+        TextLayoutCache::Stats stats = app->textLayouts.getStats();
+        sol::table result = lua.create_table();
+        result["entries"] = stats.entries;
+        result["hits"] = stats.hits;
+        result["misses"] = stats.misses;
+        return result;
+    };
+
     // Text input control functions
     lua["startTextInput"] = [app]() {
         if (app->window) {
@@ -220,59 +630,57 @@ void LuaBindings::setupBindings(Application* app, sol::state& lua) {
         return result;
     };
 
+    // local shift, ctrl, alt, gui = getKeyModifierFlags()
+    lua["getKeyModifierFlags"] = []() -> std::tuple<bool, bool, bool, bool> {
+        SDL_Keymod mod = SDL_GetModState();
+        return {(mod & SDL_KMOD_SHIFT) != 0, (mod & SDL_KMOD_CTRL) != 0,
+                (mod & SDL_KMOD_ALT) != 0, (mod & SDL_KMOD_GUI) != 0};
+    };
+
     // Drawing helper functions
     lua["drawLine"] = [app](float x1, float y1, float x2, float y2, float r, float g, float b, float a) {
-        if (app->renderer) {
-            SDL_SetRenderDrawColor(app->renderer,
-                static_cast<Uint8>(r * 255),
-                static_cast<Uint8>(g * 255),
-                static_cast<Uint8>(b * 255),
-                static_cast<Uint8>(a * 255));
-            SDL_RenderLine(app->renderer, x1, y1, x2, y2);
-        }
+        app->compositor.line(x1, y1, x2, y2, toColor(r, g, b, a));
     };
 
     lua["drawRectOutline"] = [app](float x, float y, float w, float h, float r, float g, float b, float a) {
-        if (app->renderer) {
-            SDL_SetRenderDrawColor(app->renderer,
-                static_cast<Uint8>(r * 255),
-                static_cast<Uint8>(g * 255),
-                static_cast<Uint8>(b * 255),
-                static_cast<Uint8>(a * 255));
-            SDL_FRect rect = {x, y, w, h};
-            SDL_RenderRect(app->renderer, &rect);
-        }
+        app->compositor.outlineRect(x, y, w, h, toColor(r, g, b, a));
     };
 
     // Text measurement helpers for cursor positioning
-    lua["measureTextToOffset"] = [app](const std::string& text, int byteOffset) -> int {
-        TTF_Font* font = app->fontManager.getCurrentFont(app->fontManager.getCurrentFontSize());
+    lua["measureTextToOffset"] = [app](std::string_view text, int byteOffset) -> int {
+        FontManager& fonts = app->fontManager;
+        TTF_Font* font = fonts.getCurrentFont(fonts.getCurrentFontSize());
         if (!font) return 0;
         if (byteOffset <= 0) return 0;
-        if (byteOffset >= static_cast<int>(text.length())) {
-            int w = 0, h = 0;
-            TTF_GetStringSize(font, text.c_str(), text.length(), &w, &h);
-            return w;
-        }
+        size_t length = std::min(static_cast<size_t>(byteOffset), text.length());
 
         int w = 0, h = 0;
-        TTF_GetStringSize(font, text.c_str(), byteOffset, &w, &h);
+        measureTextRuns(fonts, font, fonts.getCurrentFontId(), fonts.getCurrentFontSize(),
+                        text.data(), length, w, h);
         return w;
     };
 
-    lua["getOffsetFromX"] = [app](const std::string& text, float targetX) -> int {
-        TTF_Font* font = app->fontManager.getCurrentFont(app->fontManager.getCurrentFontSize());
+    lua["getOffsetFromX"] = [app](std::string_view text, float targetX) -> int {
+        FontManager& fonts = app->fontManager;
+        TTF_Font* font = fonts.getCurrentFont(fonts.getCurrentFontSize());
         if (!font || text.empty()) return 0;
         if (targetX <= 0) return 0;
 
+        int fontId = fonts.getCurrentFontId();
+        float size = fonts.getCurrentFontSize();
+        auto widthTo = [&](int offset) {
+            int w = 0, h = 0;
+            measureTextRuns(fonts, font, fontId, size, text.data(), offset, w, h);
+            return w;
+        };
+
         // Binary search for the byte offset closest to targetX
         int low = 0;
         int high = static_cast<int>(text.length());
 
         while (low < high) {
             int mid = (low + high + 1) / 2;
-            int w = 0, h = 0;
-            TTF_GetStringSize(font, text.c_str(), mid, &w, &h);
+            int w = widthTo(mid);
 
             if (w <= targetX) {
                 low = mid;
@@ -283,9 +691,8 @@ void LuaBindings::setupBindings(Application* app, sol::state& lua) {
 
         // Check if we should snap to the next character
         if (low < static_cast<int>(text.length())) {
-            int wLow = 0, wNext = 0, h = 0;
-            TTF_GetStringSize(font, text.c_str(), low, &wLow, &h);
-            TTF_GetStringSize(font, text.c_str(), low + 1, &wNext, &h);
+            int wLow = widthTo(low);
+            int wNext = widthTo(low + 1);
             float midPoint = (wLow + wNext) / 2.0f;
             if (targetX > midPoint) {
                 return low + 1;
@@ -296,125 +703,259 @@ void LuaBindings::setupBindings(Application* app, sol::state& lua) {
     };
 
     // TextWidget API
-    lua["createTextWidget"] = [app, &lua](sol::table config) -> sol::object {
-        auto widget = std::make_shared<TextWidget>();
+    // Widgets live in app->textWidgets (a generational slot map). Lua only holds a
+    // small TextWidgetHandle userdata; all methods are shared through one usertype
+    // metatable and resolve the handle in O(1).
+    lua.new_usertype<TextWidgetHandle>("TextWidget",
+        sol::no_constructor,
+
+        "setText", [app](const TextWidgetHandle& self, const std::string& text) {
+            resolveWidget(app, self).setText(text);
+        },
+        "getText", [app](const TextWidgetHandle& self) -> std::string {
+            return resolveWidget(app, self).getText();
+        },
+        "setPosition", [app](const TextWidgetHandle& self, float x, float y) {
+            resolveWidget(app, self).setPosition(x, y);
+        },
+        "setSize", [app](const TextWidgetHandle& self, float w, float h) {
+            resolveWidget(app, self).setSize(w, h);
+        },
+        "setMultiline", [app](const TextWidgetHandle& self, bool multiline) {
+            resolveWidget(app, self).setMultiline(multiline);
+        },
+        "setEditable", [app](const TextWidgetHandle& self, bool editable) {
+            resolveWidget(app, self).setEditable(editable);
+        },
+        "setFocus", [app](const TextWidgetHandle& self, bool focus) {
+            resolveWidget(app, self).setFocus(focus);
+        },
+        "hasFocus", [app](const TextWidgetHandle& self) -> bool {
+            return resolveWidget(app, self).hasFocus();
+        },
+        // Manual update/render still work; the frame stamp keeps the native
+        // passes from repeating the work in the same frame
+        "update", [app](const TextWidgetHandle& self, float dt) {
+            TextWidget& widget = resolveWidget(app, self);
+            if (widget.lastUpdateFrame == app->frameCounter) return;
+            widget.update(dt);
+            widget.lastUpdateFrame = app->frameCounter;
+        },
+        "render", [app](const TextWidgetHandle& self) {
+            TextWidget& widget = resolveWidget(app, self);
+            app->compositor.widget(self.slot, widget);
+            widget.lastRenderFrame = app->frameCounter;
+        },
+
+        // Scheduling flags for the native update/render passes
+        "visible", sol::property(
+            [app](const TextWidgetHandle& self) { return resolveWidget(app, self).visible; },
+            [app](const TextWidgetHandle& self, bool visible) { resolveWidget(app, self).visible = visible; }),
+        "active", sol::property(
+            [app](const TextWidgetHandle& self) { return resolveWidget(app, self).active; },
+            [app](const TextWidgetHandle& self, bool active) { resolveWidget(app, self).active = active; }),
+        "setZOrder", [app](const TextWidgetHandle& self, int z) {
+            TextWidget& widget = resolveWidget(app, self);
+            if (widget.zOrder != z) {
+                widget.zOrder = z;
+                app->widgetDrawOrderDirty = true;
+            }
+        },
+        "getZOrder", [app](const TextWidgetHandle& self) -> int {
+            return resolveWidget(app, self).zOrder;
+        },
+
+        // Stale handles are allowed here: destroy is idempotent
+        "isValid", [app](const TextWidgetHandle& self) -> bool {
+            return app->textWidgets.contains(self.slot);
+        },
+        "destroy", [app](const TextWidgetHandle& self) {
+            if (TextWidget* widget = app->textWidgets.get(self.slot)) {
+                app->renderCache.release(widget->getCacheKey());
+                app->fontManager.unpinFont(widget->getFont());
+                app->textWidgets.erase(self.slot);
+                app->widgetDrawOrderDirty = true;
+            }
+        },
+
+        sol::meta_function::equal_to, [](const TextWidgetHandle& a, const TextWidgetHandle& b) {
+            return a.slot == b.slot;
+        }
+    );
+
+    lua["createTextWidget"] = [app](sol::table config) -> TextWidgetHandle {
+        TRACE_ZONE("createTextWidget");
+        SlotHandle slot = app->textWidgets.emplace();
+        TextWidget& widget = *app->textWidgets.get(slot);
 
         // Position and size
-        widget->x = config.get_or("x", 0.0f);
-        widget->y = config.get_or("y", 0.0f);
-        widget->width = config.get_or("width", 200.0f);
-        widget->height = config.get_or("height", 30.0f);
+        widget.x = config.get_or("x", 0.0f);
+        widget.y = config.get_or("y", 0.0f);
+        widget.width = config.get_or("width", 200.0f);
+        widget.height = config.get_or("height", 30.0f);
 
         // Options
-        widget->multiline = config.get_or("multiline", false);
-        widget->editable = config.get_or("editable", true);
+        widget.multiline = config.get_or("multiline", false);
+        widget.editable = config.get_or("editable", true);
 
         // Initialize with current renderer/font
         TTF_Font* font = app->fontManager.getCurrentFont(app->fontManager.getCurrentFontSize());
-        widget->init(app->renderer, app->textEngine, font, app->window);
+        widget.init(app->renderer, app->textEngine, font, app->window, &app->renderCache);
+        // The widget holds on to the raw TTF_Font*: keep it out of eviction,
+        // and let SDL_ttf take missing glyphs from the font's fallback chain
+        app->fontManager.pinFont(font);
+        app->fontManager.attachFallbacks(font);
 
-        // Store widget
-        int widgetId = app->nextWidgetId++;
-        app->textWidgets[widgetId] = widget;
+        // Optional scheduling flags
+        widget.visible = config.get_or("visible", true);
+        widget.active = config.get_or("active", true);
+        widget.zOrder = config.get_or("zOrder", 0);
 
-        // Create Lua userdata table with methods
-        sol::table widgetTable = lua.create_table();
-        widgetTable["_id"] = widgetId;
+        app->widgetDrawOrder.push_back(slot);
+        app->widgetDrawOrderDirty = true;
 
-        widgetTable["setText"] = [app](sol::table self, const std::string& text) {
-            int id = self["_id"];
-            auto it = app->textWidgets.find(id);
-            if (it != app->textWidgets.end()) {
-                it->second->setText(text);
-            }
-        };
+        return TextWidgetHandle{slot};
+    };
 
-        widgetTable["getText"] = [app](sol::table self) -> std::string {
-            int id = self["_id"];
-            auto it = app->textWidgets.find(id);
-            if (it != app->textWidgets.end()) {
-                return it->second->getText();
-            }
-            return "";
-        };
+    // Draw all visible widgets now (e.g. beneath later Lua drawing). Widgets
+    // drawn here are skipped by the automatic pass after render().
+    lua["drawWidgets"] = [app]() {
+        TRACE_ZONE("drawWidgets");
+        app->renderWidgets();
+    };
 
-        widgetTable["setPosition"] = [app](sol::table self, float x, float y) {
-            int id = self["_id"];
-            auto it = app->textWidgets.find(id);
-            if (it != app->textWidgets.end()) {
-                it->second->setPosition(x, y);
-            }
-        };
+    // Damage-tracking compositor controls
+    lua["setDamageTracking"] = [app](bool enabled) {
+        app->compositor.setDamageTracking(enabled);
+    };
 
-        widgetTable["setSize"] = [app](sol::table self, float w, float h) {
-            int id = self["_id"];
-            auto it = app->textWidgets.find(id);
-            if (it != app->textWidgets.end()) {
-                it->second->setSize(w, h);
-            }
-        };
+    lua["setDamageDebug"] = [app](bool enabled) {
+        app->compositor.setDebugOverlay(enabled);
+    };
 
-        widgetTable["setMultiline"] = [app](sol::table self, bool multiline) {
-            int id = self["_id"];
-            auto it = app->textWidgets.find(id);
-            if (it != app->textWidgets.end()) {
-                it->second->setMultiline(multiline);
-            }
-        };
+    lua["addDamage"] = [app](float x, float y, float w, float h) {
+        app->compositor.addDamage(x, y, w, h);
+    };
 
-        widgetTable["setEditable"] = [app](sol::table self, bool editable) {
-            int id = self["_id"];
-            auto it = app->textWidgets.find(id);
-            if (it != app->textWidgets.end()) {
-                it->second->setEditable(editable);
-            }
-        };
+    lua["invalidateFrame"] = [app]() {
+        app->compositor.invalidate();
+    };
 
-        widgetTable["setFocus"] = [app](sol::table self, bool focus) {
-            int id = self["_id"];
-            auto it = app->textWidgets.find(id);
-            if (it != app->textWidgets.end()) {
-                it->second->setFocus(focus);
-            }
-        };
+    lua["getCompositorStats"] = [app, &lua]() -> sol::table {
+        Compositor::Stats stats = app->compositor.getStats();
+        sol::table result = lua.create_table();
+        result["commands"] = stats.commands;
+        result["damageRects"] = stats.damageRects;
+        result["replayed"] = stats.replayed;
+        result["damagedArea"] = stats.damagedArea;
+        return result;
+    };
 
-        widgetTable["hasFocus"] = [app](sol::table self) -> bool {
-            int id = self["_id"];
-            auto it = app->textWidgets.find(id);
-            if (it != app->textWidgets.end()) {
-                return it->second->hasFocus();
-            }
-            return false;
-        };
+    // Widget render cache controls
+    lua["setWidgetCacheEnabled"] = [app](bool enabled) {
+        app->renderCache.setEnabled(enabled);
+        for (auto& widget : app->textWidgets) {
+            widget.markDirty();
+        }
+    };
 
-        widgetTable["update"] = [app](sol::table self, float dt) {
-            int id = self["_id"];
-            auto it = app->textWidgets.find(id);
-            if (it != app->textWidgets.end()) {
-                it->second->update(dt);
-            }
-        };
+    lua["setWidgetCacheBudget"] = [app](float megabytes) {
+        app->renderCache.setBudget(static_cast<size_t>(megabytes * 1024.0f * 1024.0f));
+    };
+
+    lua["getWidgetCacheStats"] = [app, &lua]() -> sol::table {
+        RenderCache::Stats stats = app->renderCache.getStats();
+        sol::table result = lua.create_table();
+        result["entries"] = stats.entries;
+        result["bytes"] = stats.bytes;
+        result["budgetBytes"] = stats.budgetBytes;
+        result["hits"] = stats.hits;
+        result["redraws"] = stats.redraws;
+        result["evictions"] = stats.evictions;
+        return result;
+    };
 
-        widgetTable["render"] = [app](sol::table self) {
-            int id = self["_id"];
-            auto it = app->textWidgets.find(id);
-            if (it != app->textWidgets.end()) {
-                it->second->render();
+    // Layout API
+    // Retained row/column/stack containers that position widgets. Results are
+    // cached per node and only dirty subtrees are recomputed each frame.
+    lua.new_usertype<LayoutNode>("Layout",
+        sol::no_constructor,
+
+        // add(child [, options]): child is a Layout or a TextWidget (wrapped in
+        // a leaf node); returns the child's layout node
+        "add", [](LayoutNode& self, sol::object child, sol::optional<sol::table> options) {
+            std::shared_ptr<LayoutNode> node;
+            if (child.is<LayoutNode>()) {
+                node = child.as<std::shared_ptr<LayoutNode>>();
+            } else if (child.is<TextWidgetHandle>()) {
+                node = std::make_shared<LayoutNode>();
+                node->setWidget(child.as<TextWidgetHandle>().slot);
+            } else {
+                throw sol::error("Layout:add expects a Layout or a TextWidget");
             }
-        };
+            if (options) {
+                applyLayoutOptions(*node, *options);
+            }
+            if (!self.addChild(node)) {
+                throw sol::error("Layout:add would create a cycle");
+            }
+            return node;
+        },
+        "remove", [](LayoutNode& self, const std::shared_ptr<LayoutNode>& child) {
+            self.removeChild(child);
+        },
+        "clear", [](LayoutNode& self) {
+            self.clearChildren();
+        },
+        "configure", [](LayoutNode& self, const sol::table& options) {
+            applyLayoutOptions(self, options);
+        },
+        "setFlex", [](LayoutNode& self, float flex) {
+            self.setFlex(flex);
+        },
+        "setSize", [](LayoutNode& self, sol::optional<float> w, sol::optional<float> h) {
+            self.setFixedSize(w.value_or(-1.0f), h.value_or(-1.0f));
+        },
+        "getRect", [](const LayoutNode& self) -> std::tuple<float, float, float, float> {
+            const SDL_FRect& r = self.getRect();
+            return {r.x, r.y, r.w, r.h};
+        },
+        "invalidate", [](LayoutNode& self) {
+            self.markDirty();
+        },
+        "getChildCount", [](const LayoutNode& self) -> int {
+            return static_cast<int>(self.getChildCount());
+        }
+    );
 
-        widgetTable["destroy"] = [app](sol::table self) {
-            int id = self["_id"];
-            app->textWidgets.erase(id);
-        };
+    // createLayout({direction, padding, gap, flex, width, height, widget})
+    lua["createLayout"] = [](sol::optional<sol::table> config) -> std::shared_ptr<LayoutNode> {
+        auto node = std::make_shared<LayoutNode>();
+        if (config) {
+            applyLayoutOptions(*node, *config);
+            sol::optional<TextWidgetHandle> widget = (*config)["widget"];
+            if (widget) {
+                node->setWidget(widget->slot);
+            }
+        }
+        return node;
+    };
 
-        return sol::make_object(lua, widgetTable);
+    // setRootLayout(layout) lays the tree out over the whole window; nil detaches it
+    lua["setRootLayout"] = [app](sol::object root) {
+        if (root.is<LayoutNode>()) {
+            app->rootLayout = root.as<std::shared_ptr<LayoutNode>>();
+            app->rootLayout->markDirty();
+        } else {
+            app->rootLayout.reset();
+        }
     };
 
     // Route events to widgets (called before Lua callbacks)
     lua["_routeWidgetMouseDown"] = [app](float x, float y, int button) -> bool {
-        for (auto& [id, widget] : app->textWidgets) {
-            if (widget->handleMouseDown(x, y, button)) {
+        for (auto& widget : app->textWidgets) {
+            if (!widget.acceptsInput()) continue;
+            if (widget.handleMouseDown(x, y, button)) {
                 return true;
             }
         }
@@ -422,8 +963,9 @@ void LuaBindings::setupBindings(Application* app, sol::state& lua) {
     };
 
     lua["_routeWidgetMouseUp"] = [app](float x, float y, int button) -> bool {
-        for (auto& [id, widget] : app->textWidgets) {
-            if (widget->handleMouseUp(x, y, button)) {
+        for (auto& widget : app->textWidgets) {
+            if (!widget.acceptsInput()) continue;
+            if (widget.handleMouseUp(x, y, button)) {
                 return true;
             }
         }
@@ -431,8 +973,9 @@ void LuaBindings::setupBindings(Application* app, sol::state& lua) {
     };
 
     lua["_routeWidgetMouseMove"] = [app](float x, float y) -> bool {
-        for (auto& [id, widget] : app->textWidgets) {
-            if (widget->handleMouseMove(x, y)) {
+        for (auto& widget : app->textWidgets) {
+            if (!widget.acceptsInput()) continue;
+            if (widget.handleMouseMove(x, y)) {
                 return true;
             }
         }
@@ -443,8 +986,9 @@ void LuaBindings::setupBindings(Application* app, sol::state& lua) {
         SDL_Keymod mod = SDL_GetModState();
         bool shift = (mod & SDL_KMOD_SHIFT) != 0;
         bool ctrl = (mod & SDL_KMOD_CTRL) != 0;
-        for (auto& [id, widget] : app->textWidgets) {
-            if (widget->handleKeyDown(key, shift, ctrl)) {
+        for (auto& widget : app->textWidgets) {
+            if (!widget.acceptsInput()) continue;
+            if (widget.handleKeyDown(key, shift, ctrl)) {
                 return true;
             }
         }
@@ -452,11 +996,353 @@ void LuaBindings::setupBindings(Application* app, sol::state& lua) {
     };
 
     lua["_routeWidgetTextInput"] = [app](const std::string& text) -> bool {
-        for (auto& [id, widget] : app->textWidgets) {
-            if (widget->handleTextInput(text)) {
+        for (auto& widget : app->textWidgets) {
+            if (!widget.acceptsInput()) continue;
+            if (widget.handleTextInput(text)) {
                 return true;
             }
         }
         return false;
     };
+
+    // Lua heap cap in bytes (nil or 0 = unlimited); allocations over it fail
+    // with a "not enough memory" error in the script
+    lua["setLuaMemoryLimit"] = [app](sol::optional<double> bytes) {
+        app->luaAllocator.setLimit(bytes && *bytes > 0 ? static_cast<size_t>(*bytes) : 0);
+    };
+
+    lua["getLuaMemoryStats"] = [app, &lua]() -> sol::table {
+        LuaAllocator::Stats stats = app->luaAllocator.getStats();
+        sol::table result = lua.create_table();
+        result["live"] = stats.liveBytes;
+        result["peak"] = stats.peakBytes;
+        result["limit"] = stats.limitBytes;
+        result["pooled"] = stats.pooledBytes;
+        result["allocations"] = stats.allocations;
+        result["frees"] = stats.frees;
+        result["frameAllocations"] = stats.frameAllocations;
+        result["frameFrees"] = stats.frameFrees;
+        result["frameBytes"] = stats.frameBytes;
+        result["failures"] = stats.failures;
+        result["pooling"] = stats.pooling;
+        return result;
+    };
+
+    // GC pacing: setGcBudget(ms, pause, forceRatio); 0 ms returns the
+    // collector to Lua's automatic mode
+    lua["setGcBudget"] = [app](double ms, sol::optional<double> pause, sol::optional<double> forceRatio) {
+        app->gcScheduler.setBudget(ms);
+        if (pause || forceRatio) {
+            app->gcScheduler.setThresholds(pause.value_or(1.5), forceRatio.value_or(3.0));
+        }
+    };
+
+    lua["getGcStats"] = [app, &lua]() -> sol::table {
+        GcScheduler::Stats stats = app->gcScheduler.getStats();
+        sol::table result = lua.create_table();
+        result["enabled"] = stats.enabled;
+        result["budget"] = stats.budgetMs;
+        result["heap"] = stats.heapBytes;
+        result["baseline"] = stats.baselineBytes;
+        result["cycles"] = stats.cycles;
+        result["forcedFrames"] = stats.forcedFrames;
+        return result;
+    };
+
+    // Watchdog: setScriptBudget(hardMs, softMs?) aborts a callback that runs
+    // past hardMs with a Lua error and warns past softMs; 0 turns it off
+    lua["setScriptBudget"] = [app](double hardMs, sol::optional<double> softMs) {
+        app->scriptWatchdog.setBudget(hardMs, softMs.value_or(0.0));
+    };
+
+    // { enabled, hard, soft, update = {calls, softOverruns, aborts, max}, ... }
+    lua["getScriptBudgetStats"] = [app, &lua]() -> sol::table {
+        ScriptWatchdog::Stats stats = app->scriptWatchdog.getStats();
+        sol::table result = lua.create_table();
+        result["enabled"] = stats.enabled;
+        result["hard"] = stats.hardMs;
+        result["soft"] = stats.softMs;
+        for (const ScriptWatchdog::CallbackStats& callback : stats.callbacks) {
+            result[callback.name] = lua.create_table_with(
+                "calls", callback.calls,
+                "softOverruns", callback.softOverruns,
+                "aborts", callback.aborts,
+                "max", callback.maxMs);
+        }
+        return result;
+    };
+
+    lua["resetScriptBudgetStats"] = [app]() {
+        app->scriptWatchdog.resetStats();
+    };
+
+    // Timings of the last completed frame in milliseconds
+    lua["getFrameStats"] = [app, &lua]() -> sol::table {
+        const FrameStats& stats = app->frameStats;
+        sol::table result = lua.create_table();
+        result["update"] = stats.updateMs;
+        result["render"] = stats.renderMs;
+        result["present"] = stats.presentMs;
+        result["gc"] = stats.gcMs;
+        result["frame"] = stats.frameMs;
+        result["gcSteps"] = stats.gcSteps;
+        result["gcForced"] = stats.gcForced;
+        result["drawCalls"] = stats.drawCalls;
+        result["textObjects"] = stats.textObjects;
+        result["events"] = stats.events;
+        return result;
+    };
+
+    // Stress runs: frames completed after beginFrameSeries(scene, n) form one
+    // series of the --frame-csv output and --thresholds check
+    lua["beginFrameSeries"] = [app](const std::string& scene, int n) {
+        app->frameRecorder.begin(scene, n);
+    };
+
+    lua["endFrameSeries"] = [app]() {
+        app->frameRecorder.end();
+    };
+
+    lua["isHeadless"] = [app]() -> bool {
+        return app->headless;
+    };
+
+    // Synthetic input: pushEvent(type, fields) queues an SDL event that is
+    // handled next frame exactly like real input
+    lua["pushEvent"] = [app](const std::string& type, sol::optional<sol::table> fields) -> bool {
+        auto number = [&fields](const char* key, float fallback) {
+            return fields ? fields->get_or(key, fallback) : fallback;
+        };
+        auto flag = [&fields](const char* key) {
+            return fields ? fields->get_or(key, false) : false;
+        };
+        auto text = [&fields](const char* key) {
+            return fields ? fields->get_or<std::string>(key, "") : std::string();
+        };
+
+        SDL_Event event;
+        SDL_zero(event);
+        event.common.timestamp = SDL_GetTicksNS();
+        SDL_WindowID windowID = app->window ? SDL_GetWindowID(app->window) : 0;
+
+        if (type == "mousemotion") {
+            event.type = SDL_EVENT_MOUSE_MOTION;
+            event.motion.windowID = windowID;
+            event.motion.x = number("x", 0.0f);
+            event.motion.y = number("y", 0.0f);
+            event.motion.xrel = number("dx", 0.0f);
+            event.motion.yrel = number("dy", 0.0f);
+        } else if (type == "mousedown" || type == "mouseup") {
+            event.type = type == "mousedown" ? SDL_EVENT_MOUSE_BUTTON_DOWN : SDL_EVENT_MOUSE_BUTTON_UP;
+            event.button.windowID = windowID;
+            event.button.x = number("x", 0.0f);
+            event.button.y = number("y", 0.0f);
+            event.button.button = static_cast<Uint8>(number("button", 1.0f));
+            event.button.down = type == "mousedown";
+            event.button.clicks = 1;
+        } else if (type == "wheel") {
+            event.type = SDL_EVENT_MOUSE_WHEEL;
+            event.wheel.windowID = windowID;
+            event.wheel.x = number("dx", 0.0f);
+            event.wheel.y = number("dy", 0.0f);
+            event.wheel.mouse_x = number("x", 0.0f);
+            event.wheel.mouse_y = number("y", 0.0f);
+        } else if (type == "keydown" || type == "keyup") {
+            SDL_Keycode key = SDL_GetKeyFromName(text("key").c_str());
+            if (key == SDLK_UNKNOWN) {
+                throw sol::error("pushEvent: unknown key '" + text("key") + "'");
+            }
+            event.type = type == "keydown" ? SDL_EVENT_KEY_DOWN : SDL_EVENT_KEY_UP;
+            event.key.windowID = windowID;
+            event.key.key = key;
+            event.key.scancode = SDL_GetScancodeFromKey(key, nullptr);
+            event.key.down = type == "keydown";
+            event.key.mod = static_cast<SDL_Keymod>((flag("ctrl") ? SDL_KMOD_LCTRL : 0) |
+                                                    (flag("shift") ? SDL_KMOD_LSHIFT : 0));
+        } else if (type == "textinput") {
+            // SDL keeps the pointer; the text lives until the event is handled
+            app->syntheticText.push_back(text("text"));
+            event.type = SDL_EVENT_TEXT_INPUT;
+            event.text.windowID = windowID;
+            event.text.text = app->syntheticText.back().c_str();
+        } else {
+            throw sol::error("pushEvent: unknown event type '" + type + "'");
+        }
+        return SDL_PushEvent(&event);
+    };
+
+    // Input capture: events handled from the next frame on are recorded
+    // until stopInputRecording(path) writes them (replay with --replay=path)
+    lua["startInputRecording"] = [app]() {
+        app->inputRecorder.startRecording();
+    };
+
+    lua["stopInputRecording"] = [app](const std::string& path) -> bool {
+        app->inputRecordOutput.clear();
+        return app->inputRecorder.stopRecording(path);
+    };
+
+    lua["isReplaying"] = [app]() -> bool {
+        return app->inputRecorder.getMode() == InputRecorder::Mode::Replaying &&
+               !app->inputRecorder.isReplayFinished();
+    };
+
+    // Input-to-present latency in ms per event type:
+    // { keydown = {count, p50, p95, p99, max}, mousemotion = {...}, ... }
+    lua["getInputLatency"] = [app, &lua]() -> sol::table {
+        sol::table result = lua.create_table();
+        for (const LatencyTracker::Summary& summary : app->inputLatency.summarize()) {
+            result[summary.type] = lua.create_table_with(
+                "count", summary.count,
+                "p50", summary.p50Ms,
+                "p95", summary.p95Ms,
+                "p99", summary.p99Ms,
+                "max", summary.maxMs);
+        }
+        return result;
+    };
+
+    lua["resetInputLatency"] = [app]() {
+        app->inputLatency.reset();
+    };
+
+    // Performance HUD (also toggled with F3)
+    lua["setPerfOverlay"] = [app](bool visible) {
+        app->perfOverlay.setVisible(visible);
+    };
+
+    // Sampling profiler: startProfiler(intervalMs); stopProfiler(path) writes
+    // collapsed stacks for flame graph tools and returns the sample count
+    lua["startProfiler"] = [app](sol::optional<int> intervalMs) -> bool {
+        // The main thread: the calling coroutine may be collected before
+        // stop() runs. A failed start leaves a running session's samples
+        if (!app->profiler.start(app->lua.lua_state(), intervalMs.value_or(1))) return false;
+        app->profiler.clear();
+        return true;
+    };
+
+    lua["stopProfiler"] = [app](sol::optional<std::string> path) -> double {
+        app->profiler.stop();
+        if (path) {
+            app->profiler.write(*path);
+        }
+        return static_cast<double>(app->profiler.getSampleCount());
+    };
+
+    // JIT trace diagnostics: setJitDiagnostics(true) starts collecting trace
+    // events, getJitReport() ranks functions and bindings by trace aborts
+    lua["setJitDiagnostics"] = [app](bool enabled) -> bool {
+        if (!enabled) {
+            app->jitDiagnostics.disable();
+            return true;
+        }
+        // On the main state: the references it keeps outlive a calling coroutine
+        return app->jitDiagnostics.enable(app->lua, app->bindingNames);
+    };
+
+    lua["getJitReport"] = [app](sol::optional<int> maxFunctions) -> std::string {
+        return app->jitDiagnostics.report(maxFunctions.value_or(20));
+    };
+
+    // Timeline tracing: traceBegin(name) ... traceEnd() add zones to a
+    // recording started with --trace or startTrace()
+    lua["traceBegin"] = [](const std::string& name) {
+        trace::begin(name);
+    };
+
+    lua["traceEnd"] = []() {
+        trace::end();
+    };
+
+    lua["startTrace"] = []() {
+        trace::start();
+    };
+
+    // stopTrace(path) writes Chrome trace-event JSON (chrome://tracing, Perfetto)
+    lua["stopTrace"] = [](sol::optional<std::string> path) -> bool {
+        trace::stop();
+        return path ? trace::write(*path) : true;
+    };
+
+    // Allocation tracking (debug): per-binding Lua allocations of the last frame
+    lua["setAllocationTracking"] = [app](bool enabled) {
+        if (enabled) {
+            // The main thread, not the caller's: a coroutine may be collected
+            // before disable() runs at exit
+            app->allocationTracker.enable(app->lua.lua_state());
+        } else {
+            app->allocationTracker.disable();
+        }
+    };
+
+    // { [bindingName] = {allocations = n, bytes = n}, ... }; "(script)" is
+    // everything allocated outside bindings
+    lua["getAllocationStats"] = [app, &lua]() -> sol::table {
+        sol::table result = lua.create_table();
+        for (const auto& [name, counts] : app->allocationTracker.lastFrame()) {
+            result[name] = lua.create_table_with("allocations", counts.allocations, "bytes", counts.bytes);
+        }
+        return result;
+    };
+
+    // Every C function registered above can be attributed by the tracker
+    std::vector<std::string> bindingNames;
+    for (const auto& entry : lua.globals()) {
+        if (entry.first.get_type() != sol::type::string || entry.second.get_type() != sol::type::function) continue;
+        std::string name = entry.first.as<std::string>();
+        if (!libraryGlobals.count(name)) {
+            bindingNames.push_back(std::move(name));
+        }
+    }
+    bindingNames.push_back("print");  // Replaced above, still worth attributing
+
+    // The profiler names native stack frames by their C function
+    std::vector<std::pair<std::string, lua_CFunction>> bindingFunctions;
+    lua_State* L = lua.lua_state();
+    for (const auto& name : bindingNames) {
+        lua_getglobal(L, name.c_str());
+        if (lua_iscfunction(L, -1)) {
+            bindingFunctions.emplace_back(name, lua_tocfunction(L, -1));
+        }
+        lua_pop(L, 1);
+    }
+    app->profiler.setBindings(bindingFunctions);
+
+    app->bindingNames = bindingNames;
+    app->allocationTracker.setBindingNames(std::move(bindingNames));
+}
+
+int LuaBindings::measureTexts(const char* const* texts, const size_t* lengths, int count,
+                              int* widths, int* heights) {
+    if (!boundApp || !texts || count <= 0) return 0;
+
+    FontManager& fonts = boundApp->fontManager;
+    TTF_Font* font = fonts.getCurrentFont(fonts.getCurrentFontSize());
+    if (!font) return 0;
+    int fontId = fonts.getCurrentFontId();
+    float size = fonts.getCurrentFontSize();
+
+    for (int i = 0; i < count; i++) {
+        int w = 0, h = 0;
+        if (texts[i]) {
+            size_t length = lengths ? lengths[i] : SDL_strlen(texts[i]);
+            boundApp->textMeasures.measure(fonts, font, fontId, size, texts[i], length, w, h);
+        }
+        if (widths) widths[i] = w;
+        if (heights) heights[i] = h;
+    }
+    return count;
+}
+
+APP_FFI_EXPORT int app_measure_texts(const char** texts, const size_t* lengths, int count,
+                                     int* widths, int* heights) {
+    return LuaBindings::measureTexts(texts, lengths, count, widths, heights);
+}
+
+TextWidget& LuaBindings::resolveWidget(Application* app, const TextWidgetHandle& handle) {
+    TextWidget* widget = app->textWidgets.get(handle.slot);
+    if (!widget) {
+        throw sol::error("TextWidget handle is stale (the widget was destroyed)");
+    }
+    return *widget;
 }
@@ -3,13 +3,41 @@
 
 #include <sol/sol.hpp>
 
-// Forward declaration
+// Forward declarations
 class Application;
+class TextWidget;
+struct TextWidgetHandle;
 
 class LuaBindings {
 public:
     // Set up all Lua API bindings for the application
     static void setupBindings(Application* app, sol::state& lua);
+
+    // Measure `count` strings with the current font into widths/heights
+    // (lengths may be null for NUL-terminated strings); returns the number
+    // measured. Backs measureTexts and the FFI export below.
+    static int measureTexts(const char* const* texts, const size_t* lengths, int count,
+                            int* widths, int* heights);
+
+private:
+    // Application the exported C entry points act on
+    static Application* boundApp;
+
+    // Resolve a Lua-held widget handle; raises a Lua error if the handle is stale
+    static TextWidget& resolveWidget(Application* app, const TextWidgetHandle& handle);
 };
 
+// C entry point for LuaJIT FFI callers (symbols are exported from the
+// executable, see ENABLE_EXPORTS in CMakeLists.txt):
+//   ffi.cdef[[int app_measure_texts(const char** texts, const size_t* lengths,
+//                                   int count, int* widths, int* heights);]]
+#if defined(_WIN32)
+#define APP_FFI_EXPORT extern "C" __declspec(dllexport)
+#else
+#define APP_FFI_EXPORT extern "C" __attribute__((visibility("default")))
+#endif
+
+APP_FFI_EXPORT int app_measure_texts(const char** texts, const size_t* lengths, int count,
+                                     int* widths, int* heights);
+
 #endif // LUABINDINGS_HPP
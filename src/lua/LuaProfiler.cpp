@@ -0,0 +1,104 @@
+#include "LuaProfiler.hpp"
+#include "../core/Log.hpp"
+#include <SDL3/SDL.h>
+#include <cstdlib>
+
+extern "C" {
+#include <luajit.h>
+}
+
+LuaProfiler::~LuaProfiler() {
+    stop();
+}
+
+void LuaProfiler::setBindings(const std::vector<std::pair<std::string, lua_CFunction>>& functions) {
+    bindings.clear();
+    for (const auto& [name, function] : functions) {
+        if (function) {
+            bindings.emplace(reinterpret_cast<uintptr_t>(function), name);
+        }
+    }
+}
+
+bool LuaProfiler::start(lua_State* state, int intervalMs) {
+    if (running || !state) return false;
+    L = state;
+
+    // "f": function-level precision, "i<n>": sampling interval in ms
+    std::string mode = "fi" + std::to_string(intervalMs > 0 ? intervalMs : 1);
+    luaJIT_profile_start(L, mode.c_str(), &LuaProfiler::onSample, this);
+    running = true;
+    return true;
+}
+
+void LuaProfiler::stop() {
+    if (!running) return;
+    luaJIT_profile_stop(L);
+    running = false;
+}
+
+bool LuaProfiler::write(const std::string& path) const {
+    SDL_IOStream* io = SDL_IOFromFile(path.c_str(), "w");
+    if (!io) {
+        logging::error("Failed to write profile ", path, ": ", SDL_GetError());
+        return false;
+    }
+    for (const auto& [stack, count] : stacks) {
+        SDL_IOprintf(io, "%s %llu\n", stack.c_str(), static_cast<unsigned long long>(count));
+    }
+    SDL_CloseIO(io);
+    logging::info("Wrote ", samples, " profile samples to ", path);
+    return true;
+}
+
+void LuaProfiler::clear() {
+    stacks.clear();
+    samples = 0;
+}
+
+void LuaProfiler::onSample(void* data, lua_State* L, int sampleCount, int vmstate) {
+    auto* self = static_cast<LuaProfiler*>(data);
+
+    // Negative depth: root frame first, as collapsed stacks expect
+    size_t length = 0;
+    const char* dump = luaJIT_profile_dumpstack(L, "pF;", -64, &length);
+    self->scratch.assign(dump, length);
+    while (!self->scratch.empty() && self->scratch.back() == ';') {
+        self->scratch.pop_back();
+    }
+    self->renameNativeFrames(self->scratch);
+
+    // The callback runs at the next bytecode, after a leaf C call has
+    // returned, so time in a binding shows as [C] under its Lua caller
+    const char* leaf = vmstate == 'G' ? "[GC]" : vmstate == 'J' ? "[JIT]" : vmstate == 'C' ? "[C]" : nullptr;
+    if (leaf) {
+        if (!self->scratch.empty()) self->scratch += ';';
+        self->scratch += leaf;
+    }
+    if (self->scratch.empty()) {
+        self->scratch = "(native)";
+    }
+
+    self->stacks[self->scratch] += sampleCount;
+    self->samples += sampleCount;
+}
+
+void LuaProfiler::renameNativeFrames(std::string& stack) const {
+    if (bindings.empty()) return;
+
+    // C functions are dumped as "@0x<address>"
+    size_t pos = 0;
+    while ((pos = stack.find("@0x", pos)) != std::string::npos) {
+        size_t end = stack.find(';', pos);
+        if (end == std::string::npos) end = stack.size();
+
+        uintptr_t address = static_cast<uintptr_t>(std::strtoull(stack.c_str() + pos + 1, nullptr, 16));
+        auto it = bindings.find(address);
+        if (it == bindings.end()) {
+            pos = end;
+            continue;
+        }
+        stack.replace(pos, end - pos, it->second);
+        pos += it->second.size();
+    }
+}
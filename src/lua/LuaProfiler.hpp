@@ -0,0 +1,61 @@
+#ifndef LUAPROFILER_HPP
+#define LUAPROFILER_HPP
+
+#include <sol/sol.hpp>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Sampling profiler for Lua code built on LuaJIT's luaJIT_profile API.
+//
+// Every sample dumps the Lua stack (root first) and counts it in a table of
+// collapsed stacks, the text format flamegraph.pl / speedscope / inferno
+// read. Samples taken in C code, the GC or the JIT compiler get a "[C]",
+// "[GC]" or "[JIT]" leaf frame. LuaJIT delivers a sample at the next
+// bytecode, when a leaf C binding has already returned, so binding time is
+// only attributed to the calling Lua function. C functions still on the
+// stack (bindings that call back into Lua) show up in dumps as raw
+// addresses; those registered by LuaBindings are renamed to their global name.
+//
+// Cost is one stack dump and a hash lookup per sample (1 ms by default), so
+// it can be left running for short windows in production builds.
+class LuaProfiler {
+private:
+    lua_State* L = nullptr;
+    bool running = false;
+    uint64_t samples = 0;
+
+    std::unordered_map<uintptr_t, std::string> bindings;   // C function -> global name
+    std::unordered_map<std::string, uint64_t> stacks;      // Collapsed stack -> samples
+    std::string scratch;
+
+public:
+    LuaProfiler() = default;
+    ~LuaProfiler();
+
+    LuaProfiler(const LuaProfiler&) = delete;
+    LuaProfiler& operator=(const LuaProfiler&) = delete;
+
+    // Names for native bindings (global name and its C function)
+    void setBindings(const std::vector<std::pair<std::string, lua_CFunction>>& functions);
+
+    // Start sampling every intervalMs milliseconds (keeps earlier samples);
+    // state must be the main thread, it is used again by stop()
+    bool start(lua_State* state, int intervalMs = 1);
+    void stop();
+    bool isRunning() const { return running; }
+
+    // Write collapsed stacks ("frame;frame;frame count" per line)
+    bool write(const std::string& path) const;
+    void clear();
+
+    uint64_t getSampleCount() const { return samples; }
+
+private:
+    static void onSample(void* data, lua_State* L, int sampleCount, int vmstate);
+    void renameNativeFrames(std::string& stack) const;
+};
+
+#endif // LUAPROFILER_HPP
@@ -0,0 +1,104 @@
+#include "ScriptWatchdog.hpp"
+#include "../core/Log.hpp"
+#include <algorithm>
+#include <cmath>
+
+extern "C" {
+#include <luajit.h>
+}
+
+ScriptWatchdog* ScriptWatchdog::instance = nullptr;
+
+namespace {
+
+const char* CALLBACK_NAMES[ScriptWatchdog::CALLBACK_COUNT] = {"update", "render", "renderOverlay", "event", "async"};
+
+} // namespace
+
+ScriptWatchdog::ScriptWatchdog() {
+    resetStats();
+}
+
+ScriptWatchdog::~ScriptWatchdog() {
+    setBudget(0.0);
+}
+
+void ScriptWatchdog::attach(lua_State* state) {
+    L = state;
+    if (hardNs > 0) {
+        setBudget(stats.hardMs, stats.softMs);
+    }
+}
+
+void ScriptWatchdog::setBudget(double hardMs, double softMs) {
+    hardMs = std::max(0.0, hardMs);
+    softMs = std::max(0.0, softMs);
+    hardNs = static_cast<Uint64>(hardMs * 1e6);
+    softNs = softMs > 0.0 && softMs < hardMs ? static_cast<Uint64>(softMs * 1e6) : 0;
+    stats.hardMs = hardMs;
+    stats.softMs = softNs > 0 ? softMs : 0.0;
+
+    bool enable = hardNs > 0;
+    if (!L || enable == enabled) {
+        enabled = enable && L;
+        stats.enabled = enabled;
+        return;
+    }
+    enabled = enable;
+    stats.enabled = enabled;
+    if (enabled) {
+        instance = this;
+        startNs = SDL_GetTicksNS();   // Set from inside a callback: count from now
+        lua_sethook(L, &ScriptWatchdog::hook, LUA_MASKCOUNT, CHECK_INSTRUCTIONS);
+        // Compiled traces never call the hook: drop the existing ones and
+        // keep the compiler off so the whole budget runs interpreted
+        luaJIT_setmode(L, 0, LUAJIT_MODE_ENGINE | LUAJIT_MODE_FLUSH);
+        luaJIT_setmode(L, 0, LUAJIT_MODE_ENGINE | LUAJIT_MODE_OFF);
+    } else {
+        lua_sethook(L, nullptr, 0, 0);
+        luaJIT_setmode(L, 0, LUAJIT_MODE_ENGINE | LUAJIT_MODE_ON);
+        if (instance == this) instance = nullptr;
+    }
+}
+
+void ScriptWatchdog::resetStats() {
+    for (int i = 0; i < CALLBACK_COUNT; i++) {
+        stats.callbacks[i] = CallbackStats{};
+        stats.callbacks[i].name = CALLBACK_NAMES[i];
+    }
+}
+
+void ScriptWatchdog::enter(Callback callback) {
+    if (depth++ > 0) return;
+    current = callback;
+    aborted = false;
+    if (enabled) startNs = SDL_GetTicksNS();
+}
+
+void ScriptWatchdog::leave() {
+    if (--depth > 0 || !enabled) return;
+    double ms = (SDL_GetTicksNS() - startNs) / 1e6;
+    CallbackStats& s = stats.callbacks[current];
+    s.calls++;
+    s.maxMs = std::max(s.maxMs, ms);
+    if (!aborted && softNs > 0 && ms * 1e6 > softNs) {
+        s.softOverruns++;
+        logging::warn("Lua ", s.name, " took ", std::round(ms * 10.0) / 10.0, " ms (soft budget ",
+                      stats.softMs, " ms)");
+    }
+}
+
+void ScriptWatchdog::hook(lua_State* L, lua_Debug* ar) {
+    (void)ar;
+    ScriptWatchdog* self = instance;
+    if (!self || self->depth == 0) return;
+    if (SDL_GetTicksNS() - self->startNs <= self->hardNs) return;
+
+    // Raised again on every check, so a pcall in the script can't swallow it
+    CallbackStats& s = self->stats.callbacks[self->current];
+    if (!self->aborted) {
+        self->aborted = true;
+        s.aborts++;
+    }
+    luaL_error(L, "script budget exceeded: %s ran over %.1f ms", s.name, self->stats.hardMs);
+}
@@ -0,0 +1,91 @@
+#ifndef SCRIPTWATCHDOG_HPP
+#define SCRIPTWATCHDOG_HPP
+
+#include <sol/sol.hpp>
+#include <SDL3/SDL.h>
+#include <cstdint>
+
+// Per-callback CPU time budget for Lua code.
+//
+// The application wraps each call into Lua (update, render, renderOverlay,
+// event callbacks, async tasks) in a Scope. While a budget is set, an
+// instruction-count hook (lua_sethook) checks the monotonic clock every
+// CHECK_INSTRUCTIONS instructions; once the current callback has run past
+// the hard limit it raises a Lua error, so an endless loop in a script
+// costs one frame instead of freezing the window. Callbacks that finish
+// over the soft limit are logged as warnings. Both are counted in stats.
+//
+// LuaJIT does not call hooks inside compiled traces: setting a budget
+// flushes existing traces and turns the JIT compiler off, so all Lua code
+// runs interpreted until the budget is cleared. Off by default.
+class ScriptWatchdog {
+public:
+    enum Callback { Update, Render, Overlay, Event, Async, CALLBACK_COUNT };
+
+    struct CallbackStats {
+        const char* name = "";
+        uint64_t calls = 0;
+        uint64_t softOverruns = 0;     // Finished over the soft limit
+        uint64_t aborts = 0;           // Stopped at the hard limit
+        double maxMs = 0.0;
+    };
+
+    struct Stats {
+        bool enabled = false;
+        double hardMs = 0.0;
+        double softMs = 0.0;
+        CallbackStats callbacks[CALLBACK_COUNT];
+    };
+
+    // Marks a call into Lua; nested scopes count towards the outermost one
+    class Scope {
+    private:
+        ScriptWatchdog& watchdog;
+
+    public:
+        Scope(ScriptWatchdog& dog, Callback callback) : watchdog(dog) { watchdog.enter(callback); }
+        ~Scope() { watchdog.leave(); }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    };
+
+    static const int CHECK_INSTRUCTIONS = 1000;
+
+private:
+    lua_State* L = nullptr;
+    bool enabled = false;
+    Uint64 hardNs = 0;
+    Uint64 softNs = 0;
+
+    int depth = 0;
+    Callback current = Update;
+    Uint64 startNs = 0;
+    bool aborted = false;              // Current scope hit the hard limit
+
+    Stats stats;
+
+    // Hooks get no user data; there is one Lua state per application
+    static ScriptWatchdog* instance;
+
+    static void hook(lua_State* L, lua_Debug* ar);
+    void enter(Callback callback);
+    void leave();
+
+public:
+    ScriptWatchdog();
+    ~ScriptWatchdog();
+
+    ScriptWatchdog(const ScriptWatchdog&) = delete;
+    ScriptWatchdog& operator=(const ScriptWatchdog&) = delete;
+
+    void attach(lua_State* state);
+
+    // Budget per callback in ms; hardMs 0 removes the hook. softMs 0 (or at
+    // least hardMs) disables the warning
+    void setBudget(double hardMs, double softMs = 0.0);
+
+    Stats getStats() const { return stats; }
+    void resetStats();
+};
+
+#endif // SCRIPTWATCHDOG_HPP
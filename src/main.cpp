@@ -1,16 +1,25 @@
 #include "Application.hpp"
 #include "lua/LuaBindings.hpp"
+#include "core/Trace.hpp"
+#include "core/Log.hpp"
+#include <algorithm>
+#include <cstdlib>
 #include <iostream>
 
-Application::Application() {
+Application::Application() : lua(luaAllocator.createState()) {
     // Initialize Lua with standard libraries
-    lua.open_libraries(sol::lib::base, sol::lib::package, sol::lib::math, sol::lib::string);
+    lua.open_libraries(sol::lib::base, sol::lib::package, sol::lib::math, sol::lib::string,
+                       sol::lib::coroutine, sol::lib::ffi, sol::lib::jit);
 
     // Expose SDL and application functions to Lua
     LuaBindings::setupBindings(this, lua);
 
+    // Collect garbage between frames rather than whenever allocations trigger it
+    gcScheduler.attach(lua.lua_state(), &luaAllocator);
+    scriptWatchdog.attach(lua.lua_state());
+
     // Initialize event handler (after Lua and other members are ready)
-    eventHandler = std::make_unique<EventHandler>(lua, textWidgets, window, running, windowWidth, windowHeight);
+    eventHandler = std::make_unique<EventHandler>(lua, textWidgets, rootLayout, window, running, windowWidth, windowHeight);
 }
 
 Application::~Application() {
@@ -18,8 +27,13 @@ Application::~Application() {
 }
 
 bool Application::initialize() {
+    // No display needed: render into an offscreen window
+    if (headless) {
+        SDL_SetHint(SDL_HINT_VIDEO_DRIVER, "offscreen");
+    }
+
     if (!SDL_Init(SDL_INIT_VIDEO)) {
-        std::cerr << "SDL_Init failed: " << SDL_GetError() << std::endl;
+        logging::error("SDL_Init failed: ", SDL_GetError());
         return false;
     }
 
@@ -30,31 +44,64 @@ bool Application::initialize() {
     );
 
     if (!window) {
-        std::cerr << "SDL_CreateWindow failed: " << SDL_GetError() << std::endl;
+        logging::error("SDL_CreateWindow failed: ", SDL_GetError());
         return false;
     }
 
-    renderer = SDL_CreateRenderer(window, nullptr);
+    renderer = SDL_CreateRenderer(window, headless ? "software" : nullptr);
     if (!renderer) {
-        std::cerr << "SDL_CreateRenderer failed: " << SDL_GetError() << std::endl;
+        logging::error("SDL_CreateRenderer failed: ", SDL_GetError());
         return false;
     }
 
     // Initialize SDL_ttf
     if (!TTF_Init()) {
-        std::cerr << "TTF_Init failed: " << SDL_GetError() << std::endl;
+        logging::error("TTF_Init failed: ", SDL_GetError());
         return false;
     }
 
     // Create text engine for GPU-accelerated text rendering
     textEngine = TTF_CreateRendererTextEngine(renderer);
     if (!textEngine) {
-        std::cerr << "TTF_CreateRendererTextEngine failed: " << SDL_GetError() << std::endl;
+        logging::error("TTF_CreateRendererTextEngine failed: ", SDL_GetError());
         return false;
     }
 
-    std::cout << "SDL3 initialized successfully" << std::endl;
-    std::cout << "LuaJIT version: " << LUA_VERSION << std::endl;
+    // Workers may open fonts, so start them once SDL_ttf is up
+    assetLoader.start(&fontManager);
+
+    renderCache.init(renderer);
+    glyphAtlases.init(renderer, &fontManager);
+    fontManager.setInstanceClosedCallback([this](TTF_Font* font) {
+        glyphAtlases.forgetFont(font);
+        compositor.forgetFont(font);
+    });
+    compositor.init(renderer, textEngine, &textWidgets);
+    compositor.setGlyphAtlases(&glyphAtlases);
+
+    // Target textures lose their contents when the render device resets
+    eventHandler->setRenderResetCallback([this]() {
+        renderCache.cleanup();
+        compositor.cleanup();
+        glyphAtlases.invalidateTextures();
+        for (auto& widget : textWidgets) {
+            widget.markDirty();
+        }
+    });
+
+    eventHandler->setInputRecorder(&inputRecorder);
+    eventHandler->setLatencyTracker(&inputLatency);
+    eventHandler->setScriptWatchdog(&scriptWatchdog);
+
+    // F3 toggles the performance overlay
+    eventHandler->setDebugKeyCallback([this](SDL_Keycode key) {
+        if (key != SDLK_F3) return false;
+        perfOverlay.toggle();
+        return true;
+    });
+
+    logging::info("SDL3 initialized successfully");
+    logging::info("LuaJIT version: ", LUA_VERSION);
 
     return true;
 }
@@ -62,60 +109,311 @@ bool Application::initialize() {
 bool Application::loadScript(const std::string& scriptPath) {
     try {
         lua.script_file(scriptPath);
-        std::cout << "Loaded script: " << scriptPath << std::endl;
+        logging::info("Loaded script: ", scriptPath);
         return true;
     } catch (const sol::error& e) {
-        std::cerr << "Lua script error: " << e.what() << std::endl;
+        logging::error("Lua script error: ", e.what());
         return false;
     }
 }
 
+void Application::startProfiling(const std::string& outputPath) {
+    profileOutput = outputPath;
+    profiler.start(lua.lua_state());
+}
+
+void Application::enableJitReport() {
+    printJitReport = jitDiagnostics.enable(lua, bindingNames);
+}
+
+void Application::startTracing(const std::string& outputPath) {
+    traceOutput = outputPath;
+    trace::start();
+}
+
+void Application::setHeadless(bool enabled, Uint64 maxFrames) {
+    headless = enabled;
+    frameLimit = maxFrames;
+}
+
+void Application::setScriptArgs(const std::vector<std::string>& args) {
+    // Lua convention: arg[0] is the script, arg[1..n] its arguments
+    sol::table table = lua.create_table();
+    for (size_t i = 0; i < args.size(); i++) {
+        table[i] = args[i];
+    }
+    lua["arg"] = table;
+}
+
+void Application::recordFrameSeries(const std::string& csvPath, const std::string& thresholds) {
+    frameCsvOutput = csvPath;
+    thresholdsPath = thresholds;
+}
+
+void Application::startInputRecording(const std::string& outputPath) {
+    inputRecordOutput = outputPath;
+    inputRecorder.startRecording();
+}
+
+bool Application::startReplay(const std::string& inputPath) {
+    if (!inputRecorder.loadReplay(inputPath)) return false;
+
+    // Same frames, same dt: timings become comparable across builds
+    fixedDeltaTime = 1.0f / 60.0f;
+    frameRecorder.begin("replay", static_cast<int>(inputRecorder.getEventCount()));
+    return true;
+}
+
 void Application::update(float deltaTime) {
+    TRACE_ZONE("Application::update");
+    // Register assets decoded in the background and run their callbacks,
+    // then resume coroutines waiting on them
+    {
+        ScriptWatchdog::Scope budget(scriptWatchdog, ScriptWatchdog::Async);
+        assetLoader.pump();
+        if (resumeAsyncTasks.valid()) {
+            sol::protected_function_result result = resumeAsyncTasks();
+            if (!result.valid()) {
+                sol::error err = result;
+                logging::error("Lua async task error: ", err.what());
+            }
+        }
+    }
+
     // Call Lua update function if it exists
     sol::optional<sol::function> updateFunc = lua["update"];
     if (updateFunc) {
+        ScriptWatchdog::Scope budget(scriptWatchdog, ScriptWatchdog::Update);
         try {
             (*updateFunc)(deltaTime);
         } catch (const sol::error& e) {
-            std::cerr << "Lua update error: " << e.what() << std::endl;
+            logging::error("Lua update error: ", e.what());
         }
     }
+
+    updateLayout();
+    updateWidgets(deltaTime);
 }
 
 void Application::render() {
-    SDL_SetRenderDrawColorFloat(renderer, bgColor.r, bgColor.g, bgColor.b, bgColor.a);
-    SDL_RenderClear(renderer);
+    TRACE_ZONE("Application::render");
+    renderCache.beginFrame(frameCounter);
+    fontManager.beginFrame(frameCounter);
+    compositor.beginFrame(windowWidth, windowHeight, bgColor);
 
     // Call Lua render function if it exists
     sol::optional<sol::function> renderFunc = lua["render"];
     if (renderFunc) {
+        ScriptWatchdog::Scope budget(scriptWatchdog, ScriptWatchdog::Render);
         try {
             (*renderFunc)();
         } catch (const sol::error& e) {
-            std::cerr << "Lua render error: " << e.what() << std::endl;
+            logging::error("Lua render error: ", e.what());
+        }
+    }
+
+    // Widgets draw on top of the Lua scene unless the script placed them
+    // itself with drawWidgets() or widget:render()
+    renderWidgets();
+
+    // Optional hook for drawing above the widgets
+    sol::optional<sol::function> overlayFunc = lua["renderOverlay"];
+    if (overlayFunc) {
+        ScriptWatchdog::Scope budget(scriptWatchdog, ScriptWatchdog::Overlay);
+        try {
+            (*overlayFunc)();
+        } catch (const sol::error& e) {
+            logging::error("Lua renderOverlay error: ", e.what());
         }
     }
 
-    SDL_RenderPresent(renderer);
+    // In damage mode this redraws only the changed regions of the frame
+    compositor.endFrame();
+
+    // Performance HUD on top of everything, outside the compositor
+    currentFrame.drawCalls = frameCounters::drawCalls;
+    currentFrame.textObjects = frameCounters::textObjects;
+    currentFrame.events = frameCounters::events;
+    if (perfOverlay.isVisible()) {
+        PerfOverlay::Info info;
+        info.luaHeapBytes = luaAllocator.getStats().liveBytes;
+        info.fontInstances = fontManager.getCacheStats().instances;
+        perfOverlay.draw(renderer, currentFrame, info);
+    }
+
+    Uint64 presentStart = SDL_GetTicksNS();
+    {
+        TRACE_ZONE("SDL_RenderPresent");
+        SDL_RenderPresent(renderer);
+    }
+    Uint64 presentEnd = SDL_GetTicksNS();
+    currentFrame.presentMs = (presentEnd - presentStart) / 1e6;
+    inputLatency.presented(presentEnd);
+
+    // Evict textures of widgets not seen recently / over the memory budget
+    renderCache.trim();
+}
+
+void Application::updateLayout() {
+    if (!rootLayout) return;
+    SDL_FRect bounds = {0.0f, 0.0f, static_cast<float>(windowWidth), static_cast<float>(windowHeight)};
+    rootLayout->layout(bounds, textWidgets);
+}
+
+void Application::updateWidgets(float deltaTime) {
+    for (auto& widget : textWidgets) {
+        if (!widget.needsUpdate() || widget.lastUpdateFrame == frameCounter) continue;
+        widget.update(deltaTime);
+        widget.lastUpdateFrame = frameCounter;
+    }
+}
+
+void Application::renderWidgets() {
+    if (widgetDrawOrderDirty) {
+        rebuildWidgetDrawOrder();
+    }
+
+    for (SlotHandle handle : widgetDrawOrder) {
+        TextWidget* widget = textWidgets.get(handle);
+        if (!widget || !widget->visible || widget->lastRenderFrame == frameCounter) continue;
+
+        // Skip widgets entirely outside the window
+        if (widget->x >= windowWidth || widget->y >= windowHeight ||
+            widget->x + widget->width <= 0 || widget->y + widget->height <= 0) {
+            continue;
+        }
+
+        compositor.widget(handle, *widget);
+        widget->lastRenderFrame = frameCounter;
+    }
+}
+
+void Application::rebuildWidgetDrawOrder() {
+    // New widgets are appended on creation, so a stable sort keeps creation
+    // order among widgets with equal zOrder; destroyed widgets drop out here
+    widgetDrawOrder.erase(
+        std::remove_if(widgetDrawOrder.begin(), widgetDrawOrder.end(),
+            [this](SlotHandle handle) { return !textWidgets.contains(handle); }),
+        widgetDrawOrder.end());
+    std::stable_sort(widgetDrawOrder.begin(), widgetDrawOrder.end(),
+        [this](SlotHandle a, SlotHandle b) {
+            return textWidgets.get(a)->zOrder < textWidgets.get(b)->zOrder;
+        });
+    widgetDrawOrderDirty = false;
 }
 
 void Application::run() {
+    const Uint64 frameTargetNS = 16 * SDL_NS_PER_MS; // ~60 FPS
     Uint64 lastTime = SDL_GetTicks();
 
+    trace::setThreadName("Main");
+
     while (running) {
+        TRACE_ZONE("Frame");
+        frameCounter++;
+        luaAllocator.beginFrame();
+        allocationTracker.beginFrame();
+        Uint64 frameStart = SDL_GetTicksNS();
+        currentFrame = FrameStats{};
+        frameCounters::reset();
+
         Uint64 currentTime = SDL_GetTicks();
-        float deltaTime = (currentTime - lastTime) / 1000.0f;
+        float deltaTime = fixedDeltaTime > 0.0f ? fixedDeltaTime : (currentTime - lastTime) / 1000.0f;
         lastTime = currentTime;
 
+        inputRecorder.beginFrame(frameCounter);
         eventHandler->handleEvents();
+        syntheticText.clear();
         update(deltaTime);
+        Uint64 updateEnd = SDL_GetTicksNS();
+        currentFrame.updateMs = (updateEnd - frameStart) / 1e6;
+
         render();
+        Uint64 renderEnd = SDL_GetTicksNS();
+        currentFrame.renderMs = (renderEnd - updateEnd) / 1e6 - currentFrame.presentMs;
+
+        // Garbage collection gets the slack left in the frame
+        double slackMs = (static_cast<double>(frameTargetNS) - (renderEnd - frameStart)) / 1e6;
+        GcScheduler::Result gc = gcScheduler.run(slackMs);
+        currentFrame.gcMs = gc.gcMs;
+        currentFrame.gcSteps = gc.steps;
+        currentFrame.gcForced = gc.forced;
+
+        // Headless runs go as fast as they can
+        Uint64 elapsed = SDL_GetTicksNS() - frameStart;
+        if (!headless && elapsed < frameTargetNS) {
+            SDL_DelayNS(frameTargetNS - elapsed);
+        }
+        currentFrame.frameMs = (SDL_GetTicksNS() - frameStart) / 1e6;
+        frameStats = currentFrame;
+        perfOverlay.push(frameStats);
+        frameRecorder.record(frameStats);
+
+        if (frameLimit > 0 && frameCounter >= frameLimit) {
+            running = false;
+        }
+        // A headless replay ends with its last event
+        if (headless && inputRecorder.isReplayFinished()) {
+            running = false;
+        }
+    }
+}
 
-        SDL_Delay(16); // ~60 FPS
+int Application::finishRun() {
+    if (!frameRecorder.getSeries().empty()) {
+        logging::flush();  // Keep queued lines ahead of the tables
+        frameRecorder.printSummary();
+        inputLatency.printSummary();
+    }
+    if (!frameCsvOutput.empty() && !frameRecorder.writeCsv(frameCsvOutput)) {
+        exitCode = 1;
+    }
+    if (!thresholdsPath.empty() && !frameRecorder.checkThresholds(thresholdsPath)) {
+        exitCode = 1;
     }
+    return exitCode;
 }
 
 void Application::cleanup() {
+    // Flush a profile started from the command line
+    profiler.stop();
+    if (!profileOutput.empty()) {
+        profiler.write(profileOutput);
+        profileOutput.clear();
+    }
+
+    if (!inputRecordOutput.empty()) {
+        inputRecorder.stopRecording(inputRecordOutput);
+        inputRecordOutput.clear();
+    }
+
+    if (!traceOutput.empty()) {
+        trace::stop();
+        trace::write(traceOutput);
+        traceOutput.clear();
+    }
+
+    if (printJitReport) {
+        logging::flush();
+        std::cout << jitDiagnostics.report();
+        printJitReport = false;
+    }
+    jitDiagnostics.disable();
+
+    // Restore the unwrapped bindings and allocator while the state is alive
+    allocationTracker.disable();
+
+    // Cleanup cached textures (before the renderer goes away)
+    compositor.cleanup();
+    renderCache.cleanup();
+
+    // Keep glyphs rasterised this run for the next start
+    glyphAtlases.save();
+    glyphAtlases.cleanup();
+
+    // Join loader threads before the fonts and SDL_ttf go away
+    assetLoader.stop();
+
     // Cleanup fonts
     fontManager.cleanup();
 
@@ -138,20 +436,99 @@ void Application::cleanup() {
 }
 
 int main(int argc, char* argv[]) {
+    // Declared first so lines logged during cleanup are still written
+    logging::Session logSession;
     Application app;
 
+    // Usage: SDL3_Lua_Sol3 [script.lua [script args...]] [--profile[=out.folded]] [--jit-report]
+    //        [--trace[=out.json]] [--headless[=frames]] [--frame-csv=out.csv] [--thresholds=file]
+    //        [--record[=out.rec]] [--replay=in.rec] [--log-level=debug|info|warn|error]
+    std::string scriptPath = "scripts/main.lua";
+    std::vector<std::string> scriptArgs;
+    std::string profilePath;
+    std::string tracePath;
+    std::string frameCsvPath;
+    std::string thresholdsPath;
+    std::string recordPath;
+    std::string replayPath;
+    bool jitReport = false;
+    bool headless = false;
+    Uint64 maxFrames = 0;
+    bool haveScript = false;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--profile") {
+            profilePath = "profile.folded";
+        } else if (arg.rfind("--profile=", 0) == 0) {
+            profilePath = arg.substr(10);
+        } else if (arg == "--trace") {
+            tracePath = "trace.json";
+        } else if (arg.rfind("--trace=", 0) == 0) {
+            tracePath = arg.substr(8);
+        } else if (arg == "--jit-report") {
+            jitReport = true;
+        } else if (arg == "--headless") {
+            headless = true;
+        } else if (arg.rfind("--headless=", 0) == 0) {
+            headless = true;
+            maxFrames = std::strtoull(arg.c_str() + 11, nullptr, 10);
+        } else if (arg.rfind("--frame-csv=", 0) == 0) {
+            frameCsvPath = arg.substr(12);
+        } else if (arg.rfind("--thresholds=", 0) == 0) {
+            thresholdsPath = arg.substr(13);
+        } else if (arg == "--record") {
+            recordPath = "input.rec";
+        } else if (arg.rfind("--record=", 0) == 0) {
+            recordPath = arg.substr(9);
+        } else if (arg.rfind("--replay=", 0) == 0) {
+            replayPath = arg.substr(9);
+        } else if (arg.rfind("--log-level=", 0) == 0) {
+            logging::Level level;
+            if (!logging::parseLevel(arg.substr(12), level)) {
+                logging::error("Unknown log level: ", arg.substr(12));
+                return 1;
+            }
+            logging::setLevel(level);
+        } else if (!haveScript) {
+            scriptPath = arg;
+            haveScript = true;
+        } else {
+            scriptArgs.push_back(arg);  // e.g. scene=rects sizes=100,1000
+        }
+    }
+
+    app.setHeadless(headless, maxFrames);
     if (!app.initialize()) {
         return 1;
     }
 
+    if (!profilePath.empty()) {
+        app.startProfiling(profilePath);
+    }
+    if (jitReport) {
+        app.enableJitReport();
+    }
+    if (!tracePath.empty()) {
+        app.startTracing(tracePath);
+    }
+    app.recordFrameSeries(frameCsvPath, thresholdsPath);
+    if (!recordPath.empty()) {
+        app.startInputRecording(recordPath);
+    }
+    if (!replayPath.empty() && !app.startReplay(replayPath)) {
+        return 1;
+    }
+
+    scriptArgs.insert(scriptArgs.begin(), scriptPath);
+    app.setScriptArgs(scriptArgs);
+
     // Load the Lua script (use command-line argument or default to main.lua)
-    std::string scriptPath = (argc > 1) ? argv[1] : "scripts/main.lua";
     if (!app.loadScript(scriptPath)) {
-        std::cerr << "Failed to load " << scriptPath << std::endl;
+        logging::error("Failed to load ", scriptPath);
         return 1;
     }
 
     app.run();
 
-    return 0;
+    return app.finishRun();
 }
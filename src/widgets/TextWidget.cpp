@@ -1,6 +1,14 @@
 #include "TextWidget.hpp"
+#include "../graphics/RenderCache.hpp"
+#include "../core/Trace.hpp"
+#include "../core/FrameStats.hpp"
 #include <algorithm>
 #include <cmath>
+#include <cstring>
+
+// Source of unique RenderCache keys (widgets move inside the registry, so
+// their address cannot serve as a key)
+static uint64_t nextCacheKey = 1;
 
 // Helper: Get width of text substring
 int TextWidget::getTextWidth(const std::string& str, size_t len) {
@@ -209,14 +217,18 @@ void TextWidget::ensureCursorVisible() {
     if (scrollY < 0) scrollY = 0;
 }
 
-void TextWidget::init(SDL_Renderer* r, TTF_TextEngine* te, TTF_Font* f, SDL_Window* w) {
+void TextWidget::init(SDL_Renderer* r, TTF_TextEngine* te, TTF_Font* f, SDL_Window* w,
+                      RenderCache* cache) {
     renderer = r;
     textEngine = te;
     font = f;
     window = w;
+    renderCache = cache;
+    cacheKey = nextCacheKey++;
     if (font) {
         fontHeight = TTF_GetFontHeight(font);
     }
+    markDirty();
 }
 
 void TextWidget::setFont(TTF_Font* f) {
@@ -224,6 +236,7 @@ void TextWidget::setFont(TTF_Font* f) {
     if (font) {
         fontHeight = TTF_GetFontHeight(font);
     }
+    markDirty();
 }
 
 void TextWidget::setText(const std::string& t) {
@@ -231,6 +244,7 @@ void TextWidget::setText(const std::string& t) {
     cursorPos = std::min(cursorPos, static_cast<int>(text.length()));
     clearSelection();
     ensureCursorVisible();
+    markDirty();
 }
 
 std::string TextWidget::getText() const { return text; }
@@ -241,17 +255,24 @@ void TextWidget::setPosition(float newX, float newY) {
 }
 
 void TextWidget::setSize(float w, float h) {
+    if (w == width && h == height) return;
     width = w;
     height = h;
+    markDirty();
 }
 
-void TextWidget::setMultiline(bool m) { multiline = m; }
+void TextWidget::setMultiline(bool m) {
+    if (m == multiline) return;
+    multiline = m;
+    markDirty();
+}
 void TextWidget::setEditable(bool e) { editable = e; }
 
 void TextWidget::setFocus(bool f) {
     if (f != focused) {
         focused = f;
         cursorBlink = 0.0f;
+        markDirty();  // Border color depends on focus
         if (focused && window) {
             SDL_StartTextInput(window);
         } else if (!focused && window) {
@@ -282,6 +303,7 @@ bool TextWidget::handleMouseDown(float mx, float my, int button) {
 
     setFocus(true);
     cursorBlink = 0.0f;
+    markDirty();
 
     // Calculate click position in text
     float localX = mx - x - paddingX + scrollX;
@@ -319,14 +341,16 @@ bool TextWidget::handleMouseDown(float mx, float my, int button) {
 bool TextWidget::handleMouseUp(float mx, float my, int button) {
     isDragging = false;
     // If selection is empty (start == end), clear it
-    if (selectionStart == selectionEnd) {
+    if (selectionStart == selectionEnd && selectionStart >= 0) {
         clearSelection();
+        markDirty();
     }
     return focused;
 }
 
 bool TextWidget::handleMouseMove(float mx, float my) {
     if (!isDragging || !focused) return false;
+    markDirty();
 
     float localX = mx - x - paddingX + scrollX;
     float localY = my - y - paddingY + scrollY;
@@ -351,9 +375,12 @@ bool TextWidget::handleMouseMove(float mx, float my) {
 }
 
 bool TextWidget::handleKeyDown(const std::string& key, bool shift, bool ctrl) {
+    TRACE_ZONE("TextWidget::handleKeyDown");
     if (!focused) return false;
 
     cursorBlink = 0.0f;
+    // Almost every handled key changes selection, scroll or text
+    markDirty();
 
     // Navigation
     if (key == "Left") {
@@ -547,6 +574,7 @@ bool TextWidget::handleKeyDown(const std::string& key, bool shift, bool ctrl) {
 bool TextWidget::handleTextInput(const std::string& inputText) {
     if (!focused || !editable) return false;
 
+    markDirty();
     saveUndoState();
     deleteSelection();
 
@@ -564,17 +592,75 @@ bool TextWidget::handleTextInput(const std::string& inputText) {
     return true;
 }
 
+bool TextWidget::appearanceChanged() const {
+    return std::memcmp(&renderedColors, &colors, sizeof(Colors)) != 0
+        || renderedPaddingX != paddingX
+        || renderedPaddingY != paddingY;
+}
+
+uint64_t TextWidget::getRenderVersion() {
+    if (!contentDirty && appearanceChanged()) {
+        markDirty();
+    }
+    return contentVersion;
+}
+
 void TextWidget::render() {
+    TRACE_ZONE("TextWidget::render");
     if (!renderer || !font || !textEngine) return;
 
+    if (!contentDirty && appearanceChanged()) {
+        markDirty();
+    }
+
+    // Cached path: redraw the static content into the widget's texture only
+    // when something changed, then composite one quad plus the cursor
+    if (renderCache && renderCache->isEnabled()) {
+        int texW = static_cast<int>(std::ceil(width));
+        int texH = static_cast<int>(std::ceil(height));
+        bool contentValid = false;
+        SDL_Texture* texture = renderCache->acquire(cacheKey, texW, texH, contentValid);
+        if (texture) {
+            if (!contentValid || contentDirty) {
+                SDL_Texture* previousTarget = SDL_GetRenderTarget(renderer);
+                SDL_SetRenderTarget(renderer, texture);
+                SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+                SDL_RenderClear(renderer);
+                renderContent(0.0f, 0.0f);
+                SDL_SetRenderTarget(renderer, previousTarget);
+
+                renderCache->markValid(cacheKey);
+                contentDirty = false;
+            }
+
+            SDL_FRect dstRect = {x, y, static_cast<float>(texW), static_cast<float>(texH)};
+            SDL_RenderTexture(renderer, texture, nullptr, &dstRect);
+            frameCounters::drawCalls++;
+            renderCursor(x, y);
+            return;
+        }
+    }
+
+    // Direct path (no cache available)
+    renderContent(x, y);
+    contentDirty = false;
+    renderCursor(x, y);
+}
+
+void TextWidget::renderContent(float ox, float oy) {
+    renderedColors = colors;
+    renderedPaddingX = paddingX;
+    renderedPaddingY = paddingY;
+
     // Background
     SDL_SetRenderDrawColor(renderer,
         static_cast<Uint8>(colors.bgR * 255),
         static_cast<Uint8>(colors.bgG * 255),
         static_cast<Uint8>(colors.bgB * 255),
         static_cast<Uint8>(colors.bgA * 255));
-    SDL_FRect bgRect = {x, y, width, height};
+    SDL_FRect bgRect = {ox, oy, width, height};
     SDL_RenderFillRect(renderer, &bgRect);
+    frameCounters::drawCalls++;
 
     // Border
     if (focused) {
@@ -591,18 +677,14 @@ void TextWidget::render() {
             static_cast<Uint8>(colors.borderA * 255));
     }
     SDL_RenderRect(renderer, &bgRect);
+    frameCounters::drawCalls++;
 
     // Set clip rect for text area
-    SDL_Rect clipRect = {
-        static_cast<int>(x + 1),
-        static_cast<int>(y + 1),
-        static_cast<int>(width - 2),
-        static_cast<int>(height - 2)
-    };
-    SDL_SetRenderClipRect(renderer, &clipRect);
+    SDL_Rect previousClip;
+    bool hadClip = pushTextClip(ox, oy, previousClip);
 
-    float textX = x + paddingX - scrollX;
-    float textY = y + paddingY - scrollY;
+    float textX = ox + paddingX - scrollX;
+    float textY = oy + paddingY - scrollY;
 
     // Draw selection highlight
     auto [selStart, selEnd] = getSelectionRange();
@@ -626,6 +708,7 @@ void TextWidget::render() {
                     float selX2 = textX + getTextWidth(lineText, lineSelEnd);
                     SDL_FRect selRect = {selX1, textY + i * fontHeight, selX2 - selX1, static_cast<float>(fontHeight)};
                     SDL_RenderFillRect(renderer, &selRect);
+                    frameCounters::drawCalls++;
                 }
                 pos = lineEnd + 1;
             }
@@ -634,6 +717,7 @@ void TextWidget::render() {
             float selX2 = textX + getTextWidth(text, selEnd);
             SDL_FRect selRect = {selX1, textY, selX2 - selX1, static_cast<float>(fontHeight)};
             SDL_RenderFillRect(renderer, &selRect);
+            frameCounters::drawCalls++;
         }
     }
 
@@ -655,6 +739,8 @@ void TextWidget::render() {
                         };
                         TTF_SetTextColor(ttfText, color.r, color.g, color.b, color.a);
                         TTF_DrawRendererText(ttfText, textX, textY + i * fontHeight);
+                        frameCounters::textObjects++;
+                        frameCounters::drawCalls++;
                         TTF_DestroyText(ttfText);
                     }
                 }
@@ -671,37 +757,69 @@ void TextWidget::render() {
                 };
                 TTF_SetTextColor(ttfText, color.r, color.g, color.b, color.a);
                 TTF_DrawRendererText(ttfText, textX, textY);
+                frameCounters::textObjects++;
+                frameCounters::drawCalls++;
                 TTF_DestroyText(ttfText);
             }
         }
     }
 
-    // Draw cursor
-    if (focused && cursorBlink < 0.5f) {
-        float cursorX, cursorY;
-        if (multiline) {
-            auto [lineIdx, col] = getCursorLineInfo();
-            auto lines = getLines();
-            int lineStart = 0;
-            for (int i = 0; i < lineIdx; i++) {
-                lineStart += lines[i].length + 1;
-            }
-            std::string lineText = text.substr(lineStart, col);
-            cursorX = textX + getTextWidth(lineText, col);
-            cursorY = textY + lineIdx * fontHeight;
-        } else {
-            cursorX = textX + getTextWidth(text, cursorPos);
-            cursorY = textY;
+    // Remember where the cursor goes so unchanged frames need no measuring
+    if (multiline) {
+        auto [lineIdx, col] = getCursorLineInfo();
+        auto lines = getLines();
+        int lineStart = 0;
+        for (int i = 0; i < lineIdx; i++) {
+            lineStart += lines[i].length + 1;
         }
-
-        SDL_SetRenderDrawColor(renderer,
-            static_cast<Uint8>(colors.cursorR * 255),
-            static_cast<Uint8>(colors.cursorG * 255),
-            static_cast<Uint8>(colors.cursorB * 255),
-            static_cast<Uint8>(colors.cursorA * 255));
-        SDL_RenderLine(renderer, cursorX, cursorY + 2, cursorX, cursorY + fontHeight - 2);
+        std::string lineText = text.substr(lineStart, col);
+        cursorLocalX = paddingX - scrollX + getTextWidth(lineText, col);
+        cursorLocalY = paddingY - scrollY + lineIdx * fontHeight;
+    } else {
+        cursorLocalX = paddingX - scrollX + getTextWidth(text, cursorPos);
+        cursorLocalY = paddingY - scrollY;
     }
 
     // Reset clip rect
-    SDL_SetRenderClipRect(renderer, nullptr);
+    SDL_SetRenderClipRect(renderer, hadClip ? &previousClip : nullptr);
+}
+
+void TextWidget::renderCursor(float ox, float oy) {
+    if (!isCursorVisible()) return;
+
+    float cursorX = ox + cursorLocalX;
+    float cursorY = oy + cursorLocalY;
+
+    SDL_Rect previousClip;
+    bool hadClip = pushTextClip(ox, oy, previousClip);
+
+    SDL_SetRenderDrawColor(renderer,
+        static_cast<Uint8>(colors.cursorR * 255),
+        static_cast<Uint8>(colors.cursorG * 255),
+        static_cast<Uint8>(colors.cursorB * 255),
+        static_cast<Uint8>(colors.cursorA * 255));
+    SDL_RenderLine(renderer, cursorX, cursorY + 2, cursorX, cursorY + fontHeight - 2);
+    frameCounters::drawCalls++;
+
+    SDL_SetRenderClipRect(renderer, hadClip ? &previousClip : nullptr);
+}
+
+bool TextWidget::pushTextClip(float ox, float oy, SDL_Rect& previousClip) {
+    // Nest inside any clip rect that is already active (e.g. a damage region)
+    bool hadClip = SDL_RenderClipEnabled(renderer);
+    if (hadClip) {
+        SDL_GetRenderClipRect(renderer, &previousClip);
+    }
+
+    SDL_Rect clipRect = {
+        static_cast<int>(ox + 1),
+        static_cast<int>(oy + 1),
+        static_cast<int>(width - 2),
+        static_cast<int>(height - 2)
+    };
+    if (hadClip && !SDL_GetRectIntersection(&clipRect, &previousClip, &clipRect)) {
+        clipRect = {0, 0, 0, 0};
+    }
+    SDL_SetRenderClipRect(renderer, &clipRect);
+    return hadClip;
 }
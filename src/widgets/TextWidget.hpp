@@ -7,6 +7,8 @@
 #include <vector>
 #include <utility>
 
+class RenderCache;
+
 // TextWidget class for text input/display
 class TextWidget {
 public:
@@ -16,6 +18,13 @@ public:
     bool multiline = false;
     bool editable = true;
 
+    // Scheduling flags used by the application's native widget passes
+    bool visible = true;         // Rendered and hit-tested only when visible
+    bool active = true;          // Updated and receives input only when active
+    int zOrder = 0;              // Higher values draw later (on top)
+    Uint64 lastUpdateFrame = 0;  // Frame stamps prevent double work when Lua
+    Uint64 lastRenderFrame = 0;  // still drives a widget manually
+
     // Colors (normalized 0-1)
     struct Colors {
         float bgR = 0.15f, bgG = 0.15f, bgB = 0.2f, bgA = 1.0f;
@@ -31,6 +40,9 @@ public:
     float paddingY = 6.0f;
 
 private:
+    // The benchmarks in bench/ time the private editing helpers directly
+    friend class TextWidgetBench;
+
     // State
     std::string text;
     int cursorPos = 0;           // Byte offset in text
@@ -57,6 +69,18 @@ private:
     TTF_Font* font = nullptr;
     int fontHeight = 16;
     SDL_Window* window = nullptr;
+    RenderCache* renderCache = nullptr;   // Optional; nullptr renders directly
+
+    // Render caching: static content (background, border, selection, text) is
+    // drawn into a cached texture and only re-rendered when marked dirty
+    uint64_t cacheKey = 0;
+    bool contentDirty = true;
+    uint64_t contentVersion = 0;          // Bumped whenever the content changes
+    Colors renderedColors;                // Colors/padding the cache was drawn with
+    float renderedPaddingX = 0.0f;
+    float renderedPaddingY = 0.0f;
+    float cursorLocalX = 0.0f;            // Cursor position relative to the widget,
+    float cursorLocalY = 0.0f;            // computed while drawing the content
 
     // Helper: Get width of text substring
     int getTextWidth(const std::string& str, size_t len);
@@ -102,13 +126,45 @@ private:
     // Ensure cursor is visible (auto-scroll)
     void ensureCursorVisible();
 
+    // Draw background, border, selection and text with the widget at (ox, oy)
+    void renderContent(float ox, float oy);
+
+    // Draw the blinking cursor with the widget at (ox, oy)
+    void renderCursor(float ox, float oy);
+
+    // Clip to the text area (nested in the current clip); returns whether a
+    // clip was active before, which the caller restores from previousClip
+    bool pushTextClip(float ox, float oy, SDL_Rect& previousClip);
+
+    // Whether colors or padding changed since the cached content was drawn
+    bool appearanceChanged() const;
+
 public:
     TextWidget() = default;
 
-    void init(SDL_Renderer* r, TTF_TextEngine* te, TTF_Font* f, SDL_Window* w);
+    void init(SDL_Renderer* r, TTF_TextEngine* te, TTF_Font* f, SDL_Window* w,
+              RenderCache* cache = nullptr);
+
+    // Request a redraw of the cached content (text, scroll, focus, size, ...)
+    void markDirty() {
+        contentDirty = true;
+        contentVersion++;
+    }
+
+    // Version of the widget's visible content, for change detection by the
+    // compositor (also picks up direct edits to colors and padding)
+    uint64_t getRenderVersion();
+
+    // Whether the blinking cursor is currently drawn
+    bool isCursorVisible() const { return focused && cursorBlink < 0.5f; }
+
+    // Key identifying this widget's texture in the RenderCache
+    uint64_t getCacheKey() const { return cacheKey; }
 
     void setFont(TTF_Font* f);
 
+    TTF_Font* getFont() const { return font; }
+
     void setText(const std::string& t);
 
     std::string getText() const;
@@ -124,6 +180,12 @@ public:
 
     bool hasFocus() const;
 
+    // Whether the widget currently takes part in event routing
+    bool acceptsInput() const { return visible && active; }
+
+    // Whether update() has anything to animate (only the focused cursor blinks)
+    bool needsUpdate() const { return active && focused; }
+
     bool hitTest(float px, float py);
 
     void update(float dt);
@@ -0,0 +1,16 @@
+#ifndef WIDGETREGISTRY_HPP
+#define WIDGETREGISTRY_HPP
+
+#include "../core/SlotMap.hpp"
+#include "TextWidget.hpp"
+
+// Dense storage for all live TextWidgets, indexed by generational handles
+using TextWidgetRegistry = SlotMap<TextWidget>;
+
+// Typed handle exposed to Lua as the `TextWidget` usertype.
+// Wrapping SlotHandle keeps handles of different widget kinds from mixing.
+struct TextWidgetHandle {
+    SlotHandle slot;
+};
+
+#endif // WIDGETREGISTRY_HPP